@@ -0,0 +1,225 @@
+/**
+ * @file AmrWavePropagation.cpp
+ * @brief Implementation of AmrWavePropagation
+ */
+
+#include <cmath>
+#include <limits>
+#include "AmrWavePropagation.hpp"
+#include "kernels/FWaveConstants.hpp"
+#include "tools/threads.hpp"
+
+template<typename T, typename C> C AmrWavePropagation<T, C>::computeNumericalFluxes()
+{
+	C minTimeStep = std::numeric_limits<C>::infinity();
+
+	#pragma omp parallel num_threads(m_threads) reduction(min: minTimeStep)
+	{
+		unsigned int begin, end;
+		tools::getChunk(0, size()+1, begin, end);
+
+		// Compute net updates on all edges of this thread
+		m_fwave.computeNetUpdates(&m_h[0], &m_hu[0], &m_b[0],
+			&m_hNetUpdatesLeft[0], &m_hNetUpdatesRight[0],
+			&m_huNetUpdatesLeft[0], &m_huNetUpdatesRight[0],
+			&m_waveSpeeds[0], begin, end, 1);
+
+		// CFL condition of every edge with the smaller adjacent cell
+		for (unsigned int i = begin; i < end; i++)
+			minTimeStep = std::min(minTimeStep, std::min(m_dx[i], m_dx[i+1])/m_waveSpeeds[i]);
+	}
+
+	return minTimeStep * (C) .4;
+}
+
+template<typename T, typename C> void AmrWavePropagation<T, C>::updateUnknowns(C dt)
+{
+	// Loop over all inner cells
+	#pragma omp parallel for num_threads(m_threads) schedule(static)
+	for (unsigned int i = 1; i < size()+1; i++)
+	{
+		m_h[i] -= dt/m_dx[i] * (m_hNetUpdatesRight[i-1] + m_hNetUpdatesLeft[i]);
+		m_hu[i] -= dt/m_dx[i] * (m_huNetUpdatesRight[i-1] + m_huNetUpdatesLeft[i]);
+	}
+}
+
+template<typename T, typename C> void AmrWavePropagation<T, C>::setOutflowBoundaryConditions()
+{
+	const unsigned int n = size();
+	m_h[0] = m_h[1]; m_h[n+1] = m_h[n];
+	m_hu[0] = m_hu[1]; m_hu[n+1] = m_hu[n];
+}
+
+template<typename T, typename C> bool AmrWavePropagation<T, C>::regrid()
+{
+	const unsigned int blocks = m_blocks.size();
+
+	setOutflowBoundaryConditions();
+
+	#pragma omp parallel for num_threads(m_threads) schedule(static)
+	for (unsigned int i = 0; i < blocks; i++)
+		m_indicators[i] = computeIndicator(i);
+
+	// New levels, including a buffer of one block around steep gradients
+	std::vector<unsigned int> levels(blocks);
+	for (unsigned int i = 0; i < blocks; i++)
+	{
+		C indicator = m_indicators[i];
+		if (i > 0)
+			indicator = std::max(indicator, m_indicators[i-1]);
+		if (i+1 < blocks)
+			indicator = std::max(indicator, m_indicators[i+1]);
+
+		unsigned int level = m_blocks[i].level;
+		if (indicator > m_threshold && level < m_maxLevel)
+			level++;
+		else if (indicator < m_threshold/2 && level > 0)
+			level--;
+		levels[i] = level;
+	}
+
+	// Neighbours may differ by one level only, refinement wins
+	for (unsigned int i = 1; i < blocks; i++)
+		levels[i] = std::max(levels[i], levels[i-1] > 0 ? levels[i-1]-1 : 0);
+	for (unsigned int i = blocks-1; i > 0; i--)
+		levels[i-1] = std::max(levels[i-1], levels[i] > 0 ? levels[i]-1 : 0);
+
+	bool changed = false;
+	unsigned int cells = 0;
+	for (unsigned int i = 0; i < blocks; i++)
+	{
+		changed |= levels[i] != m_blocks[i].level;
+		cells += blockCells(levels[i]);
+	}
+	if (!changed)
+		return false;
+
+	// Move the leaf cells to new arrays
+	std::vector<T> h(cells+2), hu(cells+2), b(cells+2);
+	unsigned int next = 1;
+	for (unsigned int i = 0; i < blocks; i++)
+	{
+		const unsigned int oldLevel = m_blocks[i].level;
+		const unsigned int first = m_blocks[i].first;
+		const unsigned int oldCells = blockCells(oldLevel);
+
+		m_blocks[i].level = levels[i];
+		m_blocks[i].first = next;
+
+		if (levels[i] == oldLevel)
+		{
+			std::copy(&m_h[first], &m_h[first+oldCells], &h[next]);
+			std::copy(&m_hu[first], &m_hu[first+oldCells], &hu[next]);
+			std::copy(&m_b[first], &m_b[first+oldCells], &b[next]);
+			next += oldCells;
+		}
+		else if (levels[i] > oldLevel)
+		{
+			// Both children get the values of the parent
+			for (unsigned int j = first; j < first+oldCells; j++)
+			{
+				h[next] = h[next+1] = m_h[j];
+				hu[next] = hu[next+1] = m_hu[j];
+				b[next] = b[next+1] = m_b[j];
+				next += 2;
+			}
+		}
+		else
+		{
+			// The parent gets the average of its children
+			for (unsigned int j = first; j < first+oldCells; j += 2)
+			{
+				h[next] = (m_h[j] + m_h[j+1]) / 2;
+				hu[next] = (m_hu[j] + m_hu[j+1]) / 2;
+				b[next] = (m_b[j] + m_b[j+1]) / 2;
+				next++;
+			}
+		}
+	}
+	assert(next == cells+1);
+
+	m_h.swap(h);
+	m_hu.swap(hu);
+	m_b.swap(b);
+	resize(cells);
+
+	setOutflowBoundaryConditions();
+	m_b[0] = m_b[1];
+	m_b[cells+1] = m_b[cells];
+
+	return true;
+}
+
+template<typename T, typename C> void AmrWavePropagation<T, C>::resize(unsigned int size)
+{
+	m_h.resize(size+2);
+	m_hu.resize(size+2);
+	m_b.resize(size+2);
+	m_dx.resize(size+2);
+	m_x.resize(size+1);
+
+	m_hNetUpdatesLeft.resize(size+1);
+	m_hNetUpdatesRight.resize(size+1);
+	m_huNetUpdatesLeft.resize(size+1);
+	m_huNetUpdatesRight.resize(size+1);
+	m_waveSpeeds.resize(size+1);
+
+	computeGeometry();
+}
+
+template<typename T, typename C> void AmrWavePropagation<T, C>::computeGeometry()
+{
+	for (unsigned int i = 0; i < m_blocks.size(); i++)
+	{
+		const unsigned int level = m_blocks[i].level;
+		const unsigned int first = m_blocks[i].first;
+		const C dx = (C) m_cellSize / (1u << level);
+
+		for (unsigned int j = 0; j < blockCells(level); j++)
+		{
+			m_dx[first+j] = dx;
+			// Grid point left of the cell, same values as a uniform grid on level 0
+			m_x[first+j-1] = m_cellSize * ((T) (i*m_blockSize) + (T) j / (1u << level));
+		}
+	}
+
+	const unsigned int n = size();
+	m_dx[0] = m_dx[1];
+	m_dx[n+1] = m_dx[n];
+	m_x[n] = m_cellSize * (m_blocks.size()*m_blockSize);
+}
+
+template<typename T, typename C> C AmrWavePropagation<T, C>::computeIndicator(unsigned int block) const
+{
+	const C gravity = kernels::FWaveConstants::GRAVITY;
+	const C dryTol = kernels::FWaveConstants::DRY_TOLERANCE;
+
+	const unsigned int first = m_blocks[block].first;
+	const unsigned int last = first + blockCells(m_blocks[block].level);
+
+	C indicator = 0;
+
+	// All edges of the block, including the edges to the neighbours
+	for (unsigned int i = first-1; i < last; i++)
+	{
+		const C hLeft = m_h[i];
+		const C hRight = m_h[i+1];
+
+		// Momentum jump relative to the gravity wave speed
+		C jump = std::fabs((C) m_hu[i+1] - m_hu[i])
+			/ std::sqrt(gravity * std::max(std::max(hLeft, hRight), dryTol));
+
+		// Jump of the water surface, shore lines are not refined
+		if (hLeft > dryTol && hRight > dryTol)
+			jump = std::max(jump, std::fabs((hRight + m_b[i+1]) - (hLeft + m_b[i])));
+
+		indicator = std::max(indicator, jump);
+	}
+
+	return indicator;
+}
+
+// Single, double and mixed precision
+template class AmrWavePropagation<float>;
+template class AmrWavePropagation<double>;
+template class AmrWavePropagation<float, double>;
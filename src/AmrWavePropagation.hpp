@@ -0,0 +1,243 @@
+/**
+ * @file AmrWavePropagation.hpp
+ * @brief Wave propagation on a block-structured adaptive grid
+ */
+
+#ifndef AMRWAVEPROPAGATION_H_
+#define AMRWAVEPROPAGATION_H_
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+#include "kernels/FWaveBatch.hpp"
+#include "scenarios/fill.hpp"
+
+/**
+ * @brief Supresses the solvers debug output
+ */
+#define SUPPRESS_SOLVER_DEBUG_OUTPUT
+
+// Include the solver that is currently used
+//#include "../submodules/solvers_preset/src/solver/FWave.hpp"
+#include "../submodules/solvers/src/solver/FWave.hpp"
+
+/**
+ * @brief Solves the shallow water equations on a block-structured adaptive grid
+ *
+ * The base grid is divided into blocks of blockSize cells. Every block is refined
+ * uniformly: a block on level l consists of blockSize*2^l cells of size cellSize/2^l.
+ * The levels of neighbouring blocks differ by at most one.
+ *
+ * The cells of all blocks are stored in one array from left to right (the leaf cells),
+ * with a ghost cell on both ends, so the batched f-wave kernel works on the whole
+ * domain at once. The net-updates of an edge are applied to the cells on both sides,
+ * divided by the size of the respective cell. Since the sum of the net-updates of an
+ * edge is the flux difference, this is conservative at coarse/fine interfaces as well.
+ *
+ * AmrWavePropagation::regrid refines blocks with steep gradients in the water surface
+ * or the momentum and coarsens smooth ones. Refined cells copy their parent, coarsened
+ * cells average their children, both conserve mass and momentum.
+ */
+template<typename T, typename C = T> class AmrWavePropagation
+{
+
+	public:
+
+		/**
+		 * @brief A block of base cells that is refined uniformly
+		 */
+		struct Block
+		{
+			/** @brief Refinement level (0 = base grid) */
+			unsigned int level;
+			/** @brief Index of the first leaf cell of the block */
+			unsigned int first;
+		};
+
+	private:
+
+		/** @brief The water heights of the leaf cells */
+		std::vector<T> m_h;
+		/** @brief The water fluxes of the leaf cells */
+		std::vector<T> m_hu;
+		/** @brief The bathymetries of the leaf cells */
+		std::vector<T> m_b;
+
+		/** @brief The size of every leaf cell */
+		std::vector<C> m_dx;
+		/** @brief The grid points (cell boundaries) */
+		std::vector<T> m_x;
+
+		/** @brief The left going net-updates fot the water height */
+		std::vector<C> m_hNetUpdatesLeft;
+		/** @brief The right going net-updates fot the water height */
+		std::vector<C> m_hNetUpdatesRight;
+		/** @brief The left going net-updates fot the water flux */
+		std::vector<C> m_huNetUpdatesLeft;
+		/** @brief The right going net-updates fot the water flux */
+		std::vector<C> m_huNetUpdatesRight;
+		/** @brief The wave speed of every edge */
+		std::vector<C> m_waveSpeeds;
+
+		/** @brief All blocks from left to right */
+		std::vector<Block> m_blocks;
+
+		/** @brief The refinement indicator of every block */
+		std::vector<C> m_indicators;
+
+		/** @brief Number of base cells in a block */
+		unsigned int m_blockSize;
+		/** @brief The size of a base cell */
+		T m_cellSize;
+		/** @brief The maximum refinement level */
+		unsigned int m_maxLevel;
+		/** @brief Blocks with a larger indicator are refined, blocks below the half are coarsened */
+		C m_threshold;
+
+		/** @brief Number of threads, each thread works on a contiguous chunk of the domain */
+		unsigned int m_threads;
+
+		/** @brief The batched f-wave kernel */
+		kernels::FWaveBatch<T, C> m_fwave;
+
+	public:
+
+		/**
+		 * @brief Constructor
+		 *
+		 * @param blocks Number of blocks
+		 * @param blockSize Number of base cells in a block
+		 * @param cellSize The size of a base cell
+		 * @param maxLevel The maximum refinement level
+		 * @param threshold Refinement threshold for the jumps of the water surface and the momentum
+		 * @param threads Number of threads
+		 */
+		AmrWavePropagation(unsigned int blocks, unsigned int blockSize, T cellSize,
+				unsigned int maxLevel, T threshold, unsigned int threads = 1)
+			: m_blocks(blocks), m_indicators(blocks), m_blockSize(blockSize), m_cellSize(cellSize),
+			  m_maxLevel(maxLevel), m_threshold(threshold), m_threads(std::max(threads, 1u))
+		{
+			for (unsigned int i = 0; i < blocks; i++)
+			{
+				m_blocks[i].level = 0;
+				m_blocks[i].first = 1 + i*blockSize;
+			}
+			resize(blocks*blockSize);
+		}
+
+		/**
+		 * @brief Sets the initial values on the base grid and refines up to the maximum level
+		 *
+		 * @param scenario The scenario, filled in for the base cells (see scenarios::fill)
+		 */
+		template<class Scenario> void initialize(Scenario &scenario)
+		{
+			assert(size() == m_blocks.size()*m_blockSize);
+
+			scenarios::initialize(scenario, size(), m_h.data(), m_hu.data(), m_b.data(), m_threads);
+
+			for (unsigned int level = 0; level < m_maxLevel; level++)
+				regrid();
+		}
+
+		/**
+		 * @brief The number of leaf cells (without ghost cells)
+		 */
+		unsigned int size() const
+		{
+			return m_h.size()-2;
+		}
+
+		/**
+		 * @brief The number of blocks on a refinement level
+		 */
+		unsigned int blocks(unsigned int level) const
+		{
+			unsigned int count = 0;
+			for (unsigned int i = 0; i < m_blocks.size(); i++)
+				if (m_blocks[i].level == level)
+					count++;
+			return count;
+		}
+
+		/** @brief The water heights of the leaf cells (with ghost cells) */
+		const T* h() const { return &m_h[0]; }
+		/** @brief The water fluxes of the leaf cells (with ghost cells) */
+		const T* hu() const { return &m_hu[0]; }
+		/** @brief The bathymetries of the leaf cells (with ghost cells) */
+		const T* b() const { return &m_b[0]; }
+		/** @brief The size()+1 grid points */
+		const T* x() const { return &m_x[0]; }
+
+		/**
+		 * @brief The instruction set used for computing the net-updates
+		 */
+		kernels::Isa isa() const
+		{
+			return m_fwave.isa();
+		}
+
+		/**
+		 * @brief Computes the net-updates from the unknowns
+		 *
+		 * @return The maximum possible time step, limited by the smallest cells
+		 */
+		C computeNumericalFluxes();
+
+		/**
+		 * @brief Update the unknowns with the already computed net-updates
+		 *
+		 * @param dt Time step size
+		 */
+		void updateUnknowns(C dt);
+
+		/**
+		 * @brief Updates h and hu according to the outflow condition to both boundaries
+		 */
+		void setOutflowBoundaryConditions();
+
+		/**
+		 * @brief Adapts the grid to the current unknowns
+		 *
+		 * Every block is refined or coarsened by at most one level. A block is refined
+		 * if it or one of its neighbours has a jump above the threshold, and coarsened
+		 * if all jumps are below half the threshold. Halving a smooth gradient halves
+		 * the jumps, so a refined block stays refined until the gradient decreases.
+		 *
+		 * @return True if the grid was changed
+		 */
+		bool regrid();
+
+	private:
+
+		/**
+		 * @brief Resizes all arrays for a number of leaf cells
+		 */
+		void resize(unsigned int size);
+
+		/**
+		 * @brief Computes the cell sizes and grid points of the current blocks
+		 */
+		void computeGeometry();
+
+		/**
+		 * @brief Computes the refinement indicator of a block
+		 *
+		 * @param block The block
+		 *
+		 * @return The largest jump of the water surface (wet edges) or the momentum
+		 *         (scaled by the gravity wave speed) on the edges of the block
+		 */
+		C computeIndicator(unsigned int block) const;
+
+		/**
+		 * @brief The number of leaf cells of a block on a level
+		 */
+		unsigned int blockCells(unsigned int level) const
+		{
+			return m_blockSize << level;
+		}
+
+};
+
+#endif /* AMRWAVEPROPAGATION_H_ */
@@ -0,0 +1,103 @@
+/**
+ * @file EnsembleWavePropagation.cpp
+ * @brief Implementation of EnsembleWavePropagation
+ */
+
+#include "EnsembleWavePropagation.hpp"
+#include "tools/threads.hpp"
+
+template<typename T, typename C> C EnsembleWavePropagation<T, C>::computeNumericalFluxes()
+{
+	const unsigned int members = m_members;
+	C maxWaveSpeed = 0;
+
+	if (m_waveSpeeds)
+		std::fill(m_memberWaveSpeeds, m_memberWaveSpeeds + members*m_threads, 0);
+
+	#pragma omp parallel num_threads(m_threads) reduction(max: maxWaveSpeed)
+	{
+		// Split at rows, so each thread reduces complete rows of edges
+		unsigned int begin, end;
+		unsigned int thread = tools::getChunk(0, m_size+1, begin, end);
+
+		// Edges of all members in one run, the right cell is one row further
+		maxWaveSpeed = m_fwave.computeNetUpdates(m_h, m_hu, m_b,
+			m_hNetUpdatesLeft, m_hNetUpdatesRight,
+			m_huNetUpdatesLeft, m_huNetUpdatesRight,
+			m_waveSpeeds, begin*members, end*members, members);
+
+		if (m_waveSpeeds)
+		{
+			C *memberWaveSpeeds = m_memberWaveSpeeds + members*thread;
+			for (unsigned int i = begin; i < end; i++)
+			{
+				const C *waveSpeeds = m_waveSpeeds + i*members;
+				for (unsigned int k = 0; k < members; k++)
+					memberWaveSpeeds[k] = std::max(memberWaveSpeeds[k], waveSpeeds[k]);
+			}
+		}
+	}
+
+	// Compute CFL condition
+	C minTimeStep = m_cellSize/maxWaveSpeed * (C) .4;
+	if (m_waveSpeeds)
+	{
+		for (unsigned int k = 0; k < members; k++)
+		{
+			C memberWaveSpeed = 0;
+			for (unsigned int thread = 0; thread < m_threads; thread++)
+				memberWaveSpeed = std::max(memberWaveSpeed, m_memberWaveSpeeds[members*thread + k]);
+			m_timeSteps[k] = m_cellSize/memberWaveSpeed * (C) .4;
+		}
+	}
+	else
+		std::fill(m_timeSteps, m_timeSteps + members, minTimeStep);
+
+	return minTimeStep;
+}
+
+template<typename T, typename C> void EnsembleWavePropagation<T, C>::updateUnknowns()
+{
+	const unsigned int members = m_members;
+
+	// Loop over all inner cells
+	#pragma omp parallel for num_threads(m_threads) schedule(static)
+	for (unsigned int i = 1; i < m_size+1; i++)
+	{
+		for (unsigned int k = 0; k < members; k++)
+		{
+			unsigned int j = i*members + k;
+			m_h[j] -= m_timeSteps[k]/m_cellSize * (m_hNetUpdatesRight[j-members] + m_hNetUpdatesLeft[j]);
+			m_hu[j] -= m_timeSteps[k]/m_cellSize * (m_huNetUpdatesRight[j-members] + m_huNetUpdatesLeft[j]);
+		}
+	}
+}
+
+template<typename T, typename C> void EnsembleWavePropagation<T, C>::setOutflowBoundaryConditions()
+{
+	const unsigned int members = m_members;
+
+	std::copy(m_h + members, m_h + 2*members, m_h);
+	std::copy(m_hu + members, m_hu + 2*members, m_hu);
+	std::copy(m_h + m_size*members, m_h + (m_size+1)*members, m_h + (m_size+1)*members);
+	std::copy(m_hu + m_size*members, m_hu + (m_size+1)*members, m_hu + (m_size+1)*members);
+}
+
+template<typename T, typename C> void EnsembleWavePropagation<T, C>::getMember(unsigned int member,
+	T *h, T *hu, T *b) const
+{
+	assert(member < m_members);
+
+	for (unsigned int i = 0; i < m_size+2; i++)
+	{
+		unsigned int j = i*m_members + member;
+		h[i] = m_h[j];
+		hu[i] = m_hu[j];
+		b[i] = m_b[j];
+	}
+}
+
+// Single, double and mixed precision
+template class EnsembleWavePropagation<float>;
+template class EnsembleWavePropagation<double>;
+template class EnsembleWavePropagation<float, double>;
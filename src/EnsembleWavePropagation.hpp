@@ -0,0 +1,188 @@
+/**
+ * @file EnsembleWavePropagation.hpp
+ * @brief Advances several independent domains together
+ */
+
+#ifndef ENSEMBLEWAVEPROPAGATION_H_
+#define ENSEMBLEWAVEPROPAGATION_H_
+
+#include <algorithm>
+#include <cassert>
+#include "kernels/FWaveBatch.hpp"
+#include "tools/arena.hpp"
+
+/**
+ * @brief Supresses the solvers debug output
+ */
+#define SUPPRESS_SOLVER_DEBUG_OUTPUT
+
+// Include the solver that is currently used
+//#include "../submodules/solvers_preset/src/solver/FWave.hpp"
+#include "../submodules/solvers/src/solver/FWave.hpp"
+
+/**
+ * @brief Solves an ensemble of domains with the same size, e.g. for parameter sweeps
+ *
+ * The unknowns of all members are stored cell-major and member-minor: the value
+ * of member k in cell i is located at index i*members+k. Cell i of all members
+ * is therefore a contiguous row and the batched f-wave kernel processes the edges
+ * of all members as a single run, which keeps the vector units busy even for
+ * small domains.
+ *
+ * unknowns h,hu,b,f are defined for the cells [0,..,n+1] of every member (allocated by the caller),
+ * net-updates are defined for the edges [0,..,n] of every member, see WavePropagation.
+ *
+ * All members either use the same time step (the smallest one) or their own time step.
+ */
+template<typename T, typename C = T> class EnsembleWavePropagation
+{
+
+	private:
+
+		/** @brief The water heights */
+		T *m_h;
+		/** @brief The water fluxes */
+		T *m_hu;
+		/** @brief The bathymetries */
+		T *m_b;
+
+		/** @brief The memory of the net-updates, wave speeds and time steps */
+		tools::Arena m_arena;
+
+		/** @brief The left going net-updates fot the water height */
+		C *m_hNetUpdatesLeft;
+		/** @brief The right going net-updates fot the water height */
+		C *m_hNetUpdatesRight;
+		/** @brief The left going net-updates fot the water flux */
+		C *m_huNetUpdatesLeft;
+		/** @brief The right going net-updates fot the water flux */
+		C *m_huNetUpdatesRight;
+
+		/** @brief The wave speeds of all edges (per-member time steps only) */
+		C *m_waveSpeeds;
+
+		/** @brief The maximum wave speed of every member, one row per thread (per-member time steps only) */
+		C *m_memberWaveSpeeds;
+
+		/** @brief The current time step of every member */
+		C *m_timeSteps;
+
+		/** @brief The size of the domain of a member */
+		unsigned int m_size;
+		/** @brief The number of members */
+		unsigned int m_members;
+		/** @brief The size of a cell */
+		C m_cellSize;
+
+		/** @brief Number of threads, each thread works on a contiguous chunk of cells */
+		unsigned int m_threads;
+
+		/** @brief The batched f-wave kernel */
+		kernels::FWaveBatch<T, C> m_fwave;
+
+	public:
+
+		/**
+		 * @brief Constructor
+		 *
+		 * @param[in] size Domain size (= number of cells) of a member without ghost cells
+		 * @param[in] members Number of members
+		 * @param[in] cellSize Size of one cell
+		 * @param[out] h The water heights
+		 * @param[out] hu The fluxes
+		 * @param[in] b The bathymetry
+		 * @param[in] memberTimeSteps Use a separate time step for every member
+		 * @param[in] threads Number of threads
+		 * @param[in] hugePages Back the net-updates with transparent huge pages
+		 */
+		EnsembleWavePropagation(unsigned int size, unsigned int members, T cellSize,
+				T *h, T *hu, T *b, bool memberTimeSteps = false, unsigned int threads = 1,
+				bool hugePages = false)
+			: m_h(h), m_hu(hu), m_b(b),
+			  m_arena(arenaSize(size, std::max(members, 1u), memberTimeSteps, std::max(threads, 1u)), hugePages),
+			  m_waveSpeeds(0L), m_memberWaveSpeeds(0L),
+			  m_size(size), m_members(std::max(members, 1u)), m_cellSize(cellSize),
+			  m_threads(std::max(threads, 1u))
+		{
+			m_hNetUpdatesLeft = m_arena.field<C>((size+1)*m_members);
+			m_hNetUpdatesRight = m_arena.field<C>((size+1)*m_members);
+			m_huNetUpdatesLeft = m_arena.field<C>((size+1)*m_members);
+			m_huNetUpdatesRight = m_arena.field<C>((size+1)*m_members);
+			m_timeSteps = m_arena.field<C>(m_members);
+
+			if (memberTimeSteps)
+			{
+				m_waveSpeeds = m_arena.field<C>((size+1)*m_members);
+				m_memberWaveSpeeds = m_arena.field<C>(m_members*m_threads);
+			}
+		}
+
+		/**
+		 * @brief The number of members
+		 */
+		unsigned int members() const
+		{
+			return m_members;
+		}
+
+		/**
+		 * @brief The instruction set used for computing the net-updates
+		 */
+		kernels::Isa isa() const
+		{
+			return m_fwave.isa();
+		}
+
+		/**
+		 * @brief Computes the net-updates and the time steps from the unknowns
+		 *
+		 * @return The smallest time step of all members
+		 */
+		C computeNumericalFluxes();
+
+		/**
+		 * @brief The time step of a member computed by EnsembleWavePropagation::computeNumericalFluxes
+		 *
+		 * @param member The member
+		 */
+		C timeStep(unsigned int member) const
+		{
+			return m_timeSteps[member];
+		}
+
+		/**
+		 * @brief Update the unknowns of every member with its own time step
+		 */
+		void updateUnknowns();
+
+		/**
+		 * @brief Updates h and hu according to the outflow condition to both boundaries
+		 */
+		void setOutflowBoundaryConditions();
+
+		/**
+		 * @brief Copies the values of one member (with boundary values) to separate arrays
+		 *
+		 * @param member The member
+		 * @param[out] h The water heights
+		 * @param[out] hu The fluxes
+		 * @param[out] b The bathymetry
+		 */
+		void getMember(unsigned int member, T *h, T *hu, T *b) const;
+
+	private:
+
+		/**
+		 * @brief The size of the arena with the net-updates, wave speeds and time steps
+		 */
+		static size_t arenaSize(unsigned int size, unsigned int members, bool memberTimeSteps, unsigned int threads)
+		{
+			const size_t edges = tools::Arena::padded((size+1ull)*members*sizeof(C));
+			if (memberTimeSteps)
+				return 5*edges + tools::Arena::padded(members*sizeof(C))
+					+ tools::Arena::padded(members*threads*sizeof(C));
+			return 4*edges + tools::Arena::padded(members*sizeof(C));
+		}
+};
+
+#endif /* ENSEMBLEWAVEPROPAGATION_H_ */
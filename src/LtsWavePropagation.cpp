@@ -0,0 +1,156 @@
+/**
+ * @file LtsWavePropagation.cpp
+ * @brief Implementation of LtsWavePropagation
+ */
+
+#include "LtsWavePropagation.hpp"
+
+template<typename T, typename C> C LtsWavePropagation<T, C>::computeLocalTimeStep()
+{
+	const C dt = computeLevels();
+	const unsigned int blocks = m_levels.size();
+	const unsigned int subSteps = 1u << *std::max_element(m_levels.begin(), m_levels.end());
+
+	unsigned long long cellUpdates = 0;
+
+	#pragma omp parallel num_threads(m_threads) reduction(+: cellUpdates)
+	for (unsigned int s = 0; s < subSteps; s++)
+	{
+		#pragma omp single
+		setOutflowBoundaryConditions();
+
+		// Net-updates of all due edges, every block owns the edges right of its cells
+		#pragma omp for schedule(static)
+		for (unsigned int block = 0; block < blocks; block++)
+		{
+			const unsigned int begin = blockBegin(block);
+			const unsigned int end = blockEnd(block);
+
+			if (due(m_levels[block], s))
+				m_fwave.computeNetUpdates(m_h, m_hu, m_b,
+					&m_hNetUpdatesLeft[0], &m_hNetUpdatesRight[0],
+					&m_huNetUpdatesLeft[0], &m_huNetUpdatesRight[0],
+					block == 0 ? 0 : begin, end);
+			else if (due(edgeLevel(end-1), s))
+				// Only the edge to a neighbour with a smaller time step
+				m_fwave.computeNetUpdates(m_h, m_hu, m_b,
+					&m_hNetUpdatesLeft[0], &m_hNetUpdatesRight[0],
+					&m_huNetUpdatesLeft[0], &m_huNetUpdatesRight[0],
+					end-1, end);
+		}
+
+		// Accumulate the net-updates and update the cells at the end of their time step
+		#pragma omp for schedule(static)
+		for (unsigned int block = 0; block < blocks; block++)
+		{
+			const unsigned int level = m_levels[block];
+			const unsigned int begin = blockBegin(block);
+			const unsigned int end = blockEnd(block);
+
+			accumulate(begin, s, dt);
+			if (due(level, s))
+			{
+				// Both edges of the inner cells use the level of the block
+				const C factor = dt * (1u << level) / m_cellSize;
+				for (unsigned int i = begin+1; i < end-1; i++)
+				{
+					m_hUpdates[i] += factor * (m_hNetUpdatesRight[i-1] + m_hNetUpdatesLeft[i]);
+					m_huUpdates[i] += factor * (m_huNetUpdatesRight[i-1] + m_huNetUpdatesLeft[i]);
+				}
+			}
+			if (end-1 > begin)
+				accumulate(end-1, s, dt);
+
+			if (due(level, s+1))
+			{
+				for (unsigned int i = begin; i < end; i++)
+				{
+					m_h[i] -= m_hUpdates[i];
+					m_hu[i] -= m_huUpdates[i];
+					m_hUpdates[i] = 0;
+					m_huUpdates[i] = 0;
+				}
+				cellUpdates += end - begin;
+			}
+		}
+	}
+
+	m_cellUpdates += cellUpdates;
+	m_subSteps += subSteps;
+
+	return dt * subSteps;
+}
+
+template<typename T, typename C> void LtsWavePropagation<T, C>::setOutflowBoundaryConditions()
+{
+	m_h[0] = m_h[1]; m_h[m_size+1] = m_h[m_size];
+	m_hu[0] = m_hu[1]; m_hu[m_size+1] = m_hu[m_size];
+}
+
+template<typename T, typename C> C LtsWavePropagation<T, C>::computeLevels()
+{
+	const unsigned int blocks = m_levels.size();
+
+	setOutflowBoundaryConditions();
+
+	// Wave speeds on all edges of the cells of a block
+	#pragma omp parallel for num_threads(m_threads) schedule(static)
+	for (unsigned int block = 0; block < blocks; block++)
+		m_blockWaveSpeeds[block] = m_fwave.computeMaxWaveSpeed(m_h, m_hu, m_b,
+			blockBegin(block)-1, blockEnd(block));
+
+	C maxWaveSpeed = *std::max_element(m_blockWaveSpeeds.begin(), m_blockWaveSpeeds.end());
+
+	// Largest level that satisfies the CFL condition of the block
+	for (unsigned int block = 0; block < blocks; block++)
+	{
+		unsigned int level = 0;
+		while (level < m_maxLevel && m_blockWaveSpeeds[block] * (2u << level) <= maxWaveSpeed)
+			level++;
+		m_levels[block] = level;
+	}
+
+	// Neighbours may differ by one level only, so waves entering a block still satisfy CFL < 1
+	for (unsigned int block = 1; block < blocks; block++)
+		m_levels[block] = std::min(m_levels[block], m_levels[block-1]+1);
+	for (unsigned int block = blocks-1; block > 0; block--)
+		m_levels[block-1] = std::min(m_levels[block-1], m_levels[block]+1);
+
+	// Compute CFL condition
+	return m_cellSize/maxWaveSpeed * (C) .4;
+}
+
+template<typename T, typename C> void LtsWavePropagation<T, C>::accumulate(unsigned int cell,
+	unsigned int subStep, C dt)
+{
+	const unsigned int leftLevel = edgeLevel(cell-1);
+	const unsigned int rightLevel = edgeLevel(cell);
+	const bool left = due(leftLevel, subStep);
+	const bool right = due(rightLevel, subStep);
+
+	if (left && right && leftLevel == rightLevel)
+	{
+		const C factor = dt * (1u << leftLevel) / m_cellSize;
+		m_hUpdates[cell] += factor * (m_hNetUpdatesRight[cell-1] + m_hNetUpdatesLeft[cell]);
+		m_huUpdates[cell] += factor * (m_huNetUpdatesRight[cell-1] + m_huNetUpdatesLeft[cell]);
+		return;
+	}
+
+	if (left)
+	{
+		const C factor = dt * (1u << leftLevel) / m_cellSize;
+		m_hUpdates[cell] += factor * m_hNetUpdatesRight[cell-1];
+		m_huUpdates[cell] += factor * m_huNetUpdatesRight[cell-1];
+	}
+	if (right)
+	{
+		const C factor = dt * (1u << rightLevel) / m_cellSize;
+		m_hUpdates[cell] += factor * m_hNetUpdatesLeft[cell];
+		m_huUpdates[cell] += factor * m_huNetUpdatesLeft[cell];
+	}
+}
+
+// Single, double and mixed precision
+template class LtsWavePropagation<float>;
+template class LtsWavePropagation<double>;
+template class LtsWavePropagation<float, double>;
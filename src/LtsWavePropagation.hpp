@@ -0,0 +1,216 @@
+/**
+ * @file LtsWavePropagation.hpp
+ * @brief Wave propagation with local time stepping
+ */
+
+#ifndef LTSWAVEPROPAGATION_H_
+#define LTSWAVEPROPAGATION_H_
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+#include "kernels/FWaveBatch.hpp"
+
+/**
+ * @brief Supresses the solvers debug output
+ */
+#define SUPPRESS_SOLVER_DEBUG_OUTPUT
+
+// Include the solver that is currently used
+//#include "../submodules/solvers_preset/src/solver/FWave.hpp"
+#include "../submodules/solvers/src/solver/FWave.hpp"
+
+/**
+ * @brief Solves the shallow water equations with local time steps
+ *
+ * The domain is divided into blocks of blockSize cells. At the beginning of every
+ * (macro) time step, each block gets a level k from its local wave speed, so it can
+ * use the time step 2^k*dt, where dt is the global CFL time step. The levels of
+ * neighbouring blocks differ by at most one. The macro time step is 2^K*dt, where
+ * K is the largest level.
+ *
+ * An edge uses the smaller level of its two cells. Every time an edge is due, its
+ * net-updates (multiplied by the time step of the edge) are added to both cells.
+ * A cell applies its accumulated updates at the end of its own time step, so all
+ * net-updates are applied completely and the scheme is conservative at level
+ * interfaces. With a single level it is identical to WavePropagation.
+ *
+ * Unknowns and net-updates use the same layout as in WavePropagation.
+ */
+template<typename T, typename C = T> class LtsWavePropagation
+{
+
+	private:
+
+		/** @brief The water heights */
+		T *m_h;
+		/** @brief The water fluxes */
+		T *m_hu;
+		/** @brief The bathymetries */
+		T *m_b;
+
+		/** @brief The left going net-updates fot the water height */
+		std::vector<C> m_hNetUpdatesLeft;
+		/** @brief The right going net-updates fot the water height */
+		std::vector<C> m_hNetUpdatesRight;
+		/** @brief The left going net-updates fot the water flux */
+		std::vector<C> m_huNetUpdatesLeft;
+		/** @brief The right going net-updates fot the water flux */
+		std::vector<C> m_huNetUpdatesRight;
+
+		/** @brief Accumulated updates of the water heights */
+		std::vector<C> m_hUpdates;
+		/** @brief Accumulated updates of the water fluxes */
+		std::vector<C> m_huUpdates;
+
+		/** @brief The maximum wave speed of every block */
+		std::vector<C> m_blockWaveSpeeds;
+		/** @brief The time step level of every block */
+		std::vector<unsigned int> m_levels;
+
+		/** @brief The size of the domain */
+		unsigned int m_size;
+		/** @brief The size of a cell */
+		C m_cellSize;
+		/** @brief Number of cells in a block */
+		unsigned int m_blockSize;
+		/** @brief The maximum time step level */
+		unsigned int m_maxLevel;
+
+		/** @brief Number of threads */
+		unsigned int m_threads;
+
+		/** @brief Number of cell updates so far */
+		unsigned long long m_cellUpdates;
+		/** @brief Number of (smallest) sub steps so far */
+		unsigned long long m_subSteps;
+
+		/** @brief The batched f-wave kernel */
+		kernels::FWaveBatch<T, C> m_fwave;
+
+	public:
+
+		/**
+		 * @brief Constructor
+		 *
+		 * @param[in] size Domain size (= number of cells) without ghost cells
+		 * @param[in] cellSize Size of one cell
+		 * @param[out] h The water heights
+		 * @param[out] hu The fluxes
+		 * @param[in] b The bathymetry
+		 * @param[in] blockSize Number of cells in a block
+		 * @param[in] maxLevel The maximum time step level (time step 2^maxLevel*dt)
+		 * @param[in] threads Number of threads
+		 */
+		LtsWavePropagation(unsigned int size, T cellSize, T *h, T *hu, T *b,
+				unsigned int blockSize, unsigned int maxLevel, unsigned int threads = 1)
+			: m_h(h), m_hu(hu), m_b(b),
+			  m_hNetUpdatesLeft(size+1), m_hNetUpdatesRight(size+1),
+			  m_huNetUpdatesLeft(size+1), m_huNetUpdatesRight(size+1),
+			  m_hUpdates(size+2), m_huUpdates(size+2),
+			  m_blockWaveSpeeds((size + blockSize-1) / blockSize),
+			  m_levels((size + blockSize-1) / blockSize),
+			  m_size(size), m_cellSize(cellSize), m_blockSize(blockSize), m_maxLevel(maxLevel),
+			  m_threads(std::max(threads, 1u)), m_cellUpdates(0), m_subSteps(0)
+		{
+		}
+
+		/**
+		 * @brief The instruction set used for computing the net-updates
+		 */
+		kernels::Isa isa() const
+		{
+			return m_fwave.isa();
+		}
+
+		/**
+		 * @brief Does one macro time step, every block with its own time step
+		 *
+		 * @return The length of the macro time step
+		 */
+		C computeLocalTimeStep();
+
+		/**
+		 * @brief Updates h and hu according to the outflow condition to both boundaries
+		 */
+		void setOutflowBoundaryConditions();
+
+		/**
+		 * @brief The number of blocks on a time step level in the last macro time step
+		 */
+		unsigned int blocks(unsigned int level) const
+		{
+			return std::count(m_levels.begin(), m_levels.end(), level);
+		}
+
+		/**
+		 * @brief The number of cell updates so far
+		 */
+		unsigned long long cellUpdates() const
+		{
+			return m_cellUpdates;
+		}
+
+		/**
+		 * @brief The number of cell updates global time stepping would have needed so far
+		 */
+		unsigned long long globalCellUpdates() const
+		{
+			return m_subSteps * m_size;
+		}
+
+	private:
+
+		/**
+		 * @brief Assigns the time step levels to the blocks
+		 *
+		 * @return The global CFL time step
+		 */
+		C computeLevels();
+
+		/**
+		 * @brief Adds the net-updates of the due edges of a cell to its accumulated updates
+		 *
+		 * @param cell The cell
+		 * @param subStep The current sub step
+		 * @param dt The global CFL time step
+		 */
+		void accumulate(unsigned int cell, unsigned int subStep, C dt);
+
+		/**
+		 * @brief The first cell of a block
+		 */
+		unsigned int blockBegin(unsigned int block) const
+		{
+			return 1 + block*m_blockSize;
+		}
+
+		/**
+		 * @brief One past the last cell of a block
+		 */
+		unsigned int blockEnd(unsigned int block) const
+		{
+			return std::min(1 + (block+1)*m_blockSize, m_size+1);
+		}
+
+		/**
+		 * @brief The time step level of an edge (the smaller level of its cells)
+		 */
+		unsigned int edgeLevel(unsigned int edge) const
+		{
+			unsigned int left = edge > 0 ? (edge-1) / m_blockSize : 0;
+			unsigned int right = edge < m_size ? edge / m_blockSize : m_levels.size()-1;
+			return std::min(m_levels[left], m_levels[right]);
+		}
+
+		/**
+		 * @brief Checks whether a level starts a time step in a sub step
+		 */
+		static bool due(unsigned int level, unsigned int subStep)
+		{
+			return subStep % (1u << level) == 0;
+		}
+
+};
+
+#endif /* LTSWAVEPROPAGATION_H_ */
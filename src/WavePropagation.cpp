@@ -3,56 +3,257 @@
  * @brief Implementation of WavePropagation
  */
 
+#include <algorithm>
+#include <cmath>
 #include "WavePropagation.hpp"
+#include "tools/threads.hpp"
 
+template<typename T, typename C> C WavePropagation<T, C>::computeNumericalFluxes()
+{
+	assert(m_hNetUpdatesLeft);
+
+	if (m_active)
+		return maxTimeStep(computeActiveNumericalFluxes());
+
+	// Compute CFL condition
+	return maxTimeStep(computeNumericalFluxes(0, m_size+1));
+}
 
-T WavePropagation::computeNumericalFluxes()
+template<typename T, typename C> C WavePropagation<T, C>::computeNumericalFluxes(unsigned int first, unsigned int last)
 {
-	float maxWaveSpeed = 0.f;
+	assert(m_hNetUpdatesLeft && !m_active);
 
-	// Loop over all edges
-	for (unsigned int i = 1; i < m_size+2; i++) 
-	{
-		T maxEdgeSpeed;
+	C maxWaveSpeed = 0;
 
-		// Compute net updates
-		m_solver.computeNetUpdates(m_h[i-1], m_h[i],
-			m_hu[i-1], m_hu[i],
-			m_b[i-1], m_b[i],	// Bathymetry
-			m_hNetUpdatesLeft[i-1], m_hNetUpdatesRight[i-1],
-			m_huNetUpdatesLeft[i-1], m_huNetUpdatesRight[i-1],
-			maxEdgeSpeed);
+	#pragma omp parallel num_threads(m_threads) reduction(max: maxWaveSpeed)
+	{
+		unsigned int begin, end;
+		tools::getChunk(first, last, CHUNK_ALIGNMENT, begin, end);
 
-		// Update maxWaveSpeed
-		if (maxEdgeSpeed > maxWaveSpeed) maxWaveSpeed = maxEdgeSpeed;
+		// Compute net updates on all edges of this thread
+		maxWaveSpeed = m_fwave.computeNetUpdates(m_h, m_hu, m_b,
+			m_hNetUpdatesLeft, m_hNetUpdatesRight,
+			m_huNetUpdatesLeft, m_huNetUpdatesRight,
+			begin, end);
 	}
 
-	// Compute CFL condition
-	T maxTimeStep = m_cellSize/maxWaveSpeed * .4f;
-	return maxTimeStep;
+	return maxWaveSpeed;
 }
 
-void WavePropagation::updateUnknowns(T dt)
+template<typename T, typename C> void WavePropagation<T, C>::updateUnknowns(C dt)
 {
+	assert(m_hNetUpdatesLeft);
+
+	if (m_active)
+	{
+		updateActiveUnknowns(dt);
+		return;
+	}
+
 	// Loop over all inner cells
-	for (unsigned int i = 1; i < m_size+1; i++)
+	#pragma omp parallel num_threads(m_threads)
 	{
-        m_h[i] -=  dt/m_cellSize * (m_hNetUpdatesRight[i-1] + m_hNetUpdatesLeft[i]);
-        m_hu[i] -= dt/m_cellSize * (m_huNetUpdatesRight[i-1] + m_huNetUpdatesLeft[i]);
+		unsigned int begin, end;
+		tools::getChunk(1, m_size+1, CHUNK_ALIGNMENT, begin, end);
+
+		for (unsigned int i = begin; i < end; i++)
+		{
+			m_h[i] -=  dt/m_cellSize * (m_hNetUpdatesRight[i-1] + m_hNetUpdatesLeft[i]);
+			m_hu[i] -= dt/m_cellSize * (m_huNetUpdatesRight[i-1] + m_huNetUpdatesLeft[i]);
+		}
 	}
 }
 
-void WavePropagation::setOutflowBoundaryConditions()
+template<typename T, typename C> void WavePropagation<T, C>::setOutflowBoundaryConditions()
 {
 	m_h[0] = m_h[1]; m_h[m_size+1] = m_h[m_size];
 	m_hu[0] = m_hu[1]; m_hu[m_size+1] = m_hu[m_size];
 }
 
-void WavePropagation::computeFroude()
+template<typename T, typename C> C WavePropagation<T, C>::computeFusedTimeStep()
 {
-	// Loop over all inner cells
-	for (unsigned int i = 1; i < m_size+1; i++)
+	assert(m_window);
+
+	if (m_maxWaveSpeed < 0)
+	{
+		// First time step, compute the wave speeds of the initial unknowns
+		setOutflowBoundaryConditions();
+
+		C maxWaveSpeed = 0;
+		#pragma omp parallel num_threads(m_threads) reduction(max: maxWaveSpeed)
+		{
+			unsigned int begin, end;
+			tools::getChunk(0, m_size+1, begin, end);
+			maxWaveSpeed = m_fwave.computeMaxWaveSpeed(m_h, m_hu, m_b, begin, end);
+		}
+		m_maxWaveSpeed = maxWaveSpeed;
+	}
+
+	// Compute CFL condition
+	C dt = maxTimeStep(m_maxWaveSpeed);
+
+	C maxWaveSpeed = 0;
+
+	#pragma omp parallel num_threads(m_threads) reduction(max: maxWaveSpeed)
+	{
+		// Each thread updates a contiguous chunk of cells
+		unsigned int begin, end;
+		unsigned int thread = tools::getChunk(1, m_size+1, begin, end);
+
+		// Net-updates of the edges between the chunks, the neighbour might update its cells already
+		C *boundary = m_boundaryUpdates + 4*thread;
+		m_fwave.computeNetUpdates(m_h+begin-1, m_hu+begin-1, m_b+begin-1,
+			boundary, boundary+1, boundary+2, boundary+3, 0, 1);
+		if (end == m_size+1)
+			m_fwave.computeNetUpdates(m_h+m_size, m_hu+m_size, m_b+m_size,
+				boundary+4, boundary+5, boundary+6, boundary+7, 0, 1);
+
+		#pragma omp barrier
+
+		maxWaveSpeed = sweepFused(begin, end, dt, m_window + 4*WINDOW_SIZE*thread, boundary, boundary+4);
+
+		// Boundaries for the next time step, only by the threads that updated the cells next to them
+		// (threads with an empty chunk may still start or end at a boundary)
+		if (begin == 1 && begin < end) {
+			m_h[0] = m_h[1];
+			m_hu[0] = m_hu[1];
+		}
+		if (end == m_size+1 && begin < end) {
+			m_h[m_size+1] = m_h[m_size];
+			m_hu[m_size+1] = m_hu[m_size];
+		}
+
+		#pragma omp barrier
+
+		// Wave speeds of the new unknowns on the edges between the chunks
+		maxWaveSpeed = std::max(maxWaveSpeed,
+			m_fwave.computeMaxWaveSpeed(m_h, m_hu, m_b, begin-1, begin));
+		if (end == m_size+1)
+			maxWaveSpeed = std::max(maxWaveSpeed,
+				m_fwave.computeMaxWaveSpeed(m_h, m_hu, m_b, m_size, m_size+1));
+	}
+
+	m_maxWaveSpeed = maxWaveSpeed;
+	return dt;
+}
+
+template<typename T, typename C> C WavePropagation<T, C>::sweepFused(unsigned int begin, unsigned int end, C dt,
+	C *window, const C *leftUpdates, const C *rightUpdates)
+{
+	C *hNetUpdatesLeft = window;
+	C *hNetUpdatesRight = window + WINDOW_SIZE;
+	C *huNetUpdatesLeft = window + 2*WINDOW_SIZE;
+	C *huNetUpdatesRight = window + 3*WINDOW_SIZE;
+
+	if (begin == end)
+		return 0;
+
+	// Right going net-updates of the edge left of the next cell
+	C hNetUpdateRight = leftUpdates[1];
+	C huNetUpdateRight = leftUpdates[3];
+
+	// The first edge of the updated cells without a new wave speed
+	unsigned int speedEdge = begin;
+	C maxWaveSpeed = 0;
+
+	// Loop over the inner edges in windows
+	for (unsigned int first = begin; first < end-1; first += WINDOW_SIZE)
 	{
-		m_f[i] = m_solver.computeFroude(m_h[i], m_hu[i]);
+		unsigned int last = std::min(first + WINDOW_SIZE, end-1);
+
+		// Net-updates of the edges [first, last) from the old unknowns
+		m_fwave.computeNetUpdates(m_h+first, m_hu+first, m_b+first,
+			hNetUpdatesLeft, hNetUpdatesRight,
+			huNetUpdatesLeft, huNetUpdatesRight,
+			0, last-first);
+
+		// Update the cells [first, last), cell i only needs the edges i-1 and i
+		for (unsigned int i = first; i < last; i++)
+		{
+			unsigned int j = i - first;
+			if (j > 0) {
+				hNetUpdateRight = hNetUpdatesRight[j-1];
+				huNetUpdateRight = huNetUpdatesRight[j-1];
+			}
+
+			m_h[i] -= dt/m_cellSize * (hNetUpdateRight + hNetUpdatesLeft[j]);
+			m_hu[i] -= dt/m_cellSize * (huNetUpdateRight + huNetUpdatesLeft[j]);
+		}
+		hNetUpdateRight = hNetUpdatesRight[last-first-1];
+		huNetUpdateRight = huNetUpdatesRight[last-first-1];
+
+		// Wave speeds of the new unknowns on all edges between updated cells
+		if (last > speedEdge+1)
+		{
+			maxWaveSpeed = std::max(maxWaveSpeed,
+				m_fwave.computeMaxWaveSpeed(m_h, m_hu, m_b, speedEdge, last-1));
+			speedEdge = last-1;
+		}
 	}
-}
\ No newline at end of file
+
+	// The last cell uses the edge to the next chunk
+	unsigned int i = end-1;
+	m_h[i] -= dt/m_cellSize * (hNetUpdateRight + rightUpdates[0]);
+	m_hu[i] -= dt/m_cellSize * (huNetUpdateRight + rightUpdates[2]);
+
+	// Remaining inner edges
+	maxWaveSpeed = std::max(maxWaveSpeed,
+		m_fwave.computeMaxWaveSpeed(m_h, m_hu, m_b, speedEdge, end-1));
+
+	return maxWaveSpeed;
+}
+
+template<typename T, typename C> C WavePropagation<T, C>::computeActiveNumericalFluxes()
+{
+	m_active->update();
+	const std::vector<unsigned int> &blocks = m_active->list();
+
+	#pragma omp parallel for num_threads(m_threads) schedule(static)
+	for (unsigned int n = 0; n < blocks.size(); n++)
+	{
+		const unsigned int block = blocks[n];
+
+		// All edges of the cells of the block, the left edge only if the left neighbour sleeps
+		const unsigned int begin = block > 0 && m_active->active(block-1)
+			? blockBegin(block) : blockBegin(block)-1;
+
+		m_blockWaveSpeeds[block] = m_fwave.computeNetUpdates(m_h, m_hu, m_b,
+			m_hNetUpdatesLeft, m_hNetUpdatesRight,
+			m_huNetUpdatesLeft, m_huNetUpdatesRight,
+			begin, blockEnd(block));
+	}
+
+	// Every edge is included in the wave speed of the block that computed it last
+	return *std::max_element(m_blockWaveSpeeds, m_blockWaveSpeeds + m_active->blocks());
+}
+
+template<typename T, typename C> void WavePropagation<T, C>::updateActiveUnknowns(C dt)
+{
+	const std::vector<unsigned int> &blocks = m_active->list();
+
+	#pragma omp parallel for num_threads(m_threads) schedule(static)
+	for (unsigned int n = 0; n < blocks.size(); n++)
+	{
+		const unsigned int block = blocks[n];
+
+		// Largest net-update applied to a cell of the block
+		C maxUpdate = 0;
+
+		for (unsigned int i = blockBegin(block); i < blockEnd(block); i++)
+		{
+			m_h[i] -=  dt/m_cellSize * (m_hNetUpdatesRight[i-1] + m_hNetUpdatesLeft[i]);
+			m_hu[i] -= dt/m_cellSize * (m_huNetUpdatesRight[i-1] + m_huNetUpdatesLeft[i]);
+
+			maxUpdate = std::max(maxUpdate,
+				std::max(std::max(std::fabs(m_hNetUpdatesRight[i-1]), std::fabs(m_hNetUpdatesLeft[i])),
+					std::max(std::fabs(m_huNetUpdatesRight[i-1]), std::fabs(m_huNetUpdatesLeft[i]))));
+		}
+
+		m_active->setChanged(block, maxUpdate > m_sleepThreshold);
+	}
+}
+
+// Single, double and mixed precision
+template class WavePropagation<float>;
+template class WavePropagation<double>;
+template class WavePropagation<float, double>;
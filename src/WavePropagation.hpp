@@ -6,7 +6,11 @@
 #ifndef WAVEPROPAGATION_H_
 #define WAVEPROPAGATION_H_
 
-#include "types.hpp"
+#include <algorithm>
+#include <cassert>
+#include "kernels/FWaveBatch.hpp"
+#include "tools/activeblocks.hpp"
+#include "tools/arena.hpp"
 
 /**
  * @brief Supresses the solvers debug output
@@ -44,8 +48,25 @@
   NetUpdatesLeft(i-1)
          or
   NetUpdatesRight(i-1) @endverbatim
+ *
+ * In fused mode the net-updates are not stored for the whole domain. WavePropagation::computeFusedTimeStep
+ * computes them for a small window of edges and applies them to the cells right away.
+ *
+ * With active blocks (WavePropagation::setActiveBlocks) the domain is divided into blocks and
+ * only the blocks whose cells or neighbour cells changed in the last time step are computed.
+ * The wave speeds of sleeping blocks are kept from their last computation, so the time step
+ * does not change. With a threshold of zero the result is identical to computing all blocks.
+ *
+ * The net-updates (or the windows in fused mode) are taken from a single aligned arena, edge 0 is
+ * aligned like the first inner cell of a tools::State. The chunks of the threads start at cache
+ * line boundaries, so no cache line is shared between threads.
+ *
+ * The unknowns are stored with precision T. The net-updates, the time step and the wave speeds
+ * are computed with precision C, which allows storing the unknowns in single precision while
+ * accumulating the updates in double precision (mixed precision).
+ * WavePropagation<float>, WavePropagation<double> and WavePropagation<float, double> are available.
  */
-class WavePropagation
+template<typename T, typename C = T> class WavePropagation
 {
 
 	private:
@@ -56,25 +77,47 @@ class WavePropagation
 		T *m_hu;
 		/** @brief The bathymetries */
 		T *m_b;
-		/** @brief The froude numbers */
-		T *m_f;
+
+		/** @brief The memory of the net-updates (or the windows in fused mode) */
+		tools::Arena m_arena;
 
 		/** @brief The left going net-updates fot the water height */
-		T *m_hNetUpdatesLeft;
+		C *m_hNetUpdatesLeft;
 		/** @brief The right going net-updates fot the water height */
-		T *m_hNetUpdatesRight;
+		C *m_hNetUpdatesRight;
 		/** @brief The left going net-updates fot the water flux */
-		T *m_huNetUpdatesLeft;
+		C *m_huNetUpdatesLeft;
 		/** @brief The right going net-updates fot the water flux */
-		T *m_huNetUpdatesRight;
+		C *m_huNetUpdatesRight;
+
+		/** @brief Net-updates of the current window of edges, one window per thread (fused mode only) */
+		C *m_window;
+
+		/** @brief Net-updates of the edges between the chunks of the threads (fused mode only) */
+		C *m_boundaryUpdates;
+
+		/** @brief The maximum wave speed of the current unknowns (fused mode only, negative if unknown) */
+		C m_maxWaveSpeed;
+
+		/** @brief The blocks that are computed in the current time step (active blocks only) */
+		tools::ActiveBlocks *m_active;
+		/** @brief Number of cells in a block (active blocks only) */
+		unsigned int m_blockSize;
+		/** @brief Blocks with smaller net-updates fall asleep (active blocks only) */
+		C m_sleepThreshold;
+		/** @brief The maximum wave speed of the edges computed by every block (active blocks only) */
+		C *m_blockWaveSpeeds;
 
 		/** @brief The size of the domain */
 		unsigned int m_size;
 		/** @brief The size of a cell */
-		T m_cellSize;
+		C m_cellSize;
 
-		/** @brief The solver used in WavePropagation::computeNumericalFluxes */
-		solver::FWave<T> m_solver;
+		/** @brief Number of threads, each thread works on a contiguous chunk of the domain */
+		unsigned int m_threads;
+
+		/** @brief The batched f-wave kernel used in WavePropagation::computeNumericalFluxes */
+		kernels::FWaveBatch<T, C> m_fwave;
 
 	public:
 
@@ -86,16 +129,33 @@ class WavePropagation
 		 * @param[out] h The water heights
 		 * @param[out] hu The fluxes
 		 * @param[in] b The bathymetry
-		 * @param[out] f The froude numbers
+		 * @param[in] fused Use WavePropagation::computeFusedTimeStep instead of the separate passes
+		 * @param[in] threads Number of threads
+		 * @param[in] hugePages Back the net-updates with transparent huge pages
 		 */
-		WavePropagation(unsigned int size, T cellSize, T *h, T *hu, T *b, T *f) 
-			: m_h(h), m_hu(hu), m_size(size), m_cellSize(cellSize), m_b(b), m_f(f)
+		WavePropagation(unsigned int size, T cellSize, T *h, T *hu, T *b, bool fused = false,
+				unsigned int threads = 1, bool hugePages = false)
+			: m_h(h), m_hu(hu), m_size(size), m_cellSize(cellSize), m_b(b),
+			  m_arena(arenaSize(size, fused, std::max(threads, 1u)), hugePages),
+			  m_hNetUpdatesLeft(0L), m_hNetUpdatesRight(0L), m_huNetUpdatesLeft(0L), m_huNetUpdatesRight(0L),
+			  m_window(0L), m_boundaryUpdates(0L), m_maxWaveSpeed(-1),
+			  m_active(0L), m_blockSize(0), m_sleepThreshold(0), m_blockWaveSpeeds(0L),
+			  m_threads(std::max(threads, 1u))
 		{
-			// Allocate net updates
-			m_hNetUpdatesLeft = new T[size+1];
-			m_hNetUpdatesRight = new T[size+1];
-			m_huNetUpdatesLeft = new T[size+1];
-			m_huNetUpdatesRight = new T[size+1];
+			if (fused)
+			{
+				// Only allocate the windows
+				m_window = m_arena.field<C>(4*WINDOW_SIZE*m_threads);
+				m_boundaryUpdates = m_arena.field<C>(4*(m_threads+1));
+			}
+			else
+			{
+				// Allocate net updates
+				m_hNetUpdatesLeft = m_arena.field<C>(size+1);
+				m_hNetUpdatesRight = m_arena.field<C>(size+1);
+				m_huNetUpdatesLeft = m_arena.field<C>(size+1);
+				m_huNetUpdatesRight = m_arena.field<C>(size+1);
+			}
 		}
 
 		/**
@@ -104,10 +164,48 @@ class WavePropagation
 		~WavePropagation()
 		{
 			// Free allocated memory
-			delete [] m_hNetUpdatesLeft;
-			delete [] m_hNetUpdatesRight;
-			delete [] m_huNetUpdatesLeft;
-			delete [] m_huNetUpdatesRight;
+			delete m_active;
+			delete [] m_blockWaveSpeeds;
+		}
+
+		/**
+		 * @brief Computes only the blocks that are not at rest (not in fused mode)
+		 *
+		 * A block falls asleep when none of the net-updates applied to its cells exceeds the
+		 * threshold and wakes up as soon as it or one of its neighbours changes again.
+		 * Water at rest and dry regions have zero net-updates, so a threshold of zero does
+		 * not change the result. A positive threshold also skips blocks with tiny updates.
+		 *
+		 * @param blockSize Number of cells in a block
+		 * @param threshold Largest net-update of a block that falls asleep
+		 */
+		void setActiveBlocks(unsigned int blockSize, C threshold = 0)
+		{
+			assert(m_hNetUpdatesLeft && blockSize > 0);
+
+			delete m_active;
+			delete [] m_blockWaveSpeeds;
+
+			m_blockSize = blockSize;
+			m_sleepThreshold = threshold;
+			m_active = new tools::ActiveBlocks((m_size + blockSize-1) / blockSize);
+			m_blockWaveSpeeds = new C[m_active->blocks()];
+		}
+
+		/**
+		 * @brief The number of blocks computed in the current time step (active blocks only)
+		 */
+		unsigned int activeBlocks() const
+		{
+			return m_active ? m_active->list().size() : 0;
+		}
+
+		/**
+		 * @brief The number of blocks (active blocks only)
+		 */
+		unsigned int blocks() const
+		{
+			return m_active ? m_active->blocks() : 0;
 		}
 
 		/**
@@ -115,14 +213,50 @@ class WavePropagation
 		 *
 		 * @return The maximum possible time step
 		 */
-		T computeNumericalFluxes();
+		C computeNumericalFluxes();
+
+		/**
+		 * @brief Computes the net-updates of some edges (not with active blocks)
+		 *
+		 * Allows computing the edges that do not depend on the ghost cells while
+		 * the ghost cells are exchanged with other processes.
+		 *
+		 * @param first The first edge
+		 * @param last One past the last edge
+		 *
+		 * @return The maximum wave speed of the edges
+		 */
+		C computeNumericalFluxes(unsigned int first, unsigned int last);
+
+		/**
+		 * @brief The time step of the CFL condition
+		 *
+		 * Computed with precision C. In single precision this is the former float
+		 * expression (cell size / wave speed * .4f). In mixed precision the wave speeds
+		 * and the quotient are double, so the time steps differ from a single precision
+		 * run in the last bits and the solutions drift apart over the time steps.
+		 *
+		 * @param maxWaveSpeed The maximum wave speed of all edges
+		 */
+		C maxTimeStep(C maxWaveSpeed) const
+		{
+			return m_cellSize/maxWaveSpeed * (C) .4;
+		}
+
+		/**
+		 * @brief The instruction set used for computing the net-updates
+		 */
+		kernels::Isa isa() const
+		{
+			return m_fwave.isa();
+		}
 
 		/**
 		 * @brief Update the unknowns with the already computed net-updates
 		 *
 		 * @param dt Time step size
 		 */
-		void updateUnknowns(T dt);
+		void updateUnknowns(C dt);
 
 		/**
 		 * @brief Updates h and hu according to the outflow condition to both boundaries
@@ -130,9 +264,81 @@ class WavePropagation
 		void setOutflowBoundaryConditions();
 
 		/**
-		 * @brief Computes the froude numbers
+		 * @brief Does a complete time step in a single sweep (fused mode only)
+		 *
+		 * Gives the same result as setting the boundary conditions, computing the fluxes
+		 * and updating the unknowns one after another.
+		 * The net-updates of a window of edges are applied to the cells immediately
+		 * and the wave speeds for the next time step are computed from the updated cells.
+		 * The unknowns must not be changed from outside between two time steps.
+		 *
+		 * @return The time step that was used
 		 */
-		void computeFroude();
+		C computeFusedTimeStep();
+
+	private:
+
+		/** @brief The chunks of the threads start at multiples of this many cells (one cache line) */
+		static const unsigned int CHUNK_ALIGNMENT = tools::Arena::ALIGNMENT / sizeof(T);
+
+		/** @brief Number of edges in the window of the fused time step */
+		static const unsigned int WINDOW_SIZE = 512;
+
+		/**
+		 * @brief The size of the arena with the net-updates or the windows
+		 */
+		static size_t arenaSize(unsigned int size, bool fused, unsigned int threads)
+		{
+			if (fused)
+				return tools::Arena::padded(4*WINDOW_SIZE*threads*sizeof(C))
+					+ tools::Arena::padded(4*(threads+1)*sizeof(C));
+			return 4*tools::Arena::padded((size+1)*sizeof(C));
+		}
+
+		/**
+		 * @brief Updates a chunk of cells in a single sweep
+		 *
+		 * @param begin The first cell of the chunk
+		 * @param end One past the last cell of the chunk
+		 * @param dt Time step size
+		 * @param window Memory for the net-updates of the window
+		 * @param leftUpdates Net-updates of the edge left of the chunk
+		 * @param rightUpdates Net-updates of the edge right of the chunk
+		 *
+		 * @return The maximum wave speed of the new unknowns on the edges inside the chunk
+		 */
+		C sweepFused(unsigned int begin, unsigned int end, C dt,
+			C *window, const C *leftUpdates, const C *rightUpdates);
+
+		/**
+		 * @brief Computes the net-updates of the active blocks
+		 *
+		 * @return The maximum wave speed of all blocks
+		 */
+		C computeActiveNumericalFluxes();
+
+		/**
+		 * @brief Updates the cells of the active blocks and reports the blocks that changed
+		 *
+		 * @param dt Time step size
+		 */
+		void updateActiveUnknowns(C dt);
+
+		/**
+		 * @brief The first cell of a block
+		 */
+		unsigned int blockBegin(unsigned int block) const
+		{
+			return 1 + block*m_blockSize;
+		}
+
+		/**
+		 * @brief One past the last cell of a block
+		 */
+		unsigned int blockEnd(unsigned int block) const
+		{
+			return std::min(1 + (block+1)*m_blockSize, m_size+1);
+		}
 
 };
 
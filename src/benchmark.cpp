@@ -0,0 +1,420 @@
+/**
+ * @file benchmark.cpp
+ * @brief Micro- and macro-benchmarks of the solver
+ *
+ * The microbenchmarks time the single phases of a time step on domains from a few
+ * kilobytes (L1 resident) to hundreds of megabytes (DRAM resident). The macrobenchmarks
+ * run every scenario for a number of time steps. All results are printed as a table
+ * and written as JSON, so runs of different commits can be compared.
+ *
+ * The bytes per cell are the compulsory memory traffic of a phase: every value is read
+ * or written once, net-updates of shared edges and write allocations are not counted.
+ */
+
+#include <getopt.h>
+#include <fcntl.h>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "WavePropagation.hpp"
+#include "kernels/CellBatch.hpp"
+#include "tools/arena.hpp"
+#include "tools/logger.hpp"
+#include "writer/DerivedFields.hpp"
+#include "writer/ConsoleWriter.hpp"
+
+#include "scenarios/hydraulicsup.hpp"
+#include "scenarios/hydraulicsub.hpp"
+#include "scenarios/dambreak.hpp"
+#include "scenarios/shockshock.hpp"
+#include "scenarios/rarerare.hpp"
+#include "scenarios/bathtub.hpp"
+#include "scenarios/fill.hpp"
+
+/**
+ * @brief Options of the benchmark
+ */
+struct Options
+{
+	/** @brief The smallest domain of the microbenchmarks */
+	unsigned int minSize;
+	/** @brief The largest domain of the microbenchmarks */
+	unsigned int maxSize;
+	/** @brief Domain size of the macrobenchmarks */
+	unsigned int macroSize;
+	/** @brief Time steps of the macrobenchmarks */
+	unsigned int timeSteps;
+	/** @brief Minimum measurement time of a microbenchmark in seconds */
+	double minTime;
+	/** @brief Number of threads */
+	unsigned int threads;
+	/** @brief single, double, mixed or all */
+	std::string precision;
+	/** @brief Name of the JSON file */
+	std::string output;
+};
+
+/**
+ * @brief Result of one benchmark
+ */
+struct Result
+{
+	/** @brief Name of the benchmark */
+	std::string name;
+	/** @brief Name of the precision */
+	std::string precision;
+	/** @brief Number of cells */
+	unsigned int size;
+	/** @brief Memory used by the unknowns and net-updates */
+	unsigned long long workingSet;
+	/** @brief Best time of one iteration (micro) or the whole run (macro) */
+	double seconds;
+	/** @brief Cell updates per second */
+	double cellUpdates;
+	/** @brief Compulsory memory traffic per cell update */
+	double bytesPerCell;
+};
+
+/**
+ * @brief The unknowns of a domain
+ */
+template<typename T> struct Domain
+{
+	/** @brief The memory of the unknowns, aligned like in the simulation */
+	tools::State<T> state;
+	/** @brief Water heights, momentums and bathymetries (with boundary values) */
+	T *h, *hu, *b;
+
+	/**
+	 * @brief Initializes the unknowns from a scenario
+	 */
+	template<class Scenario> Domain(unsigned int size, Scenario &scenario)
+		: state(size), h(state.h()), hu(state.hu()), b(state.b())
+	{
+		scenarios::initialize(scenario, size, h, hu, b);
+	}
+};
+
+/**
+ * @brief Runs a function repeatedly for at least a minimum time
+ *
+ * @return The best time of a single call in seconds
+ */
+template<class Function> double measure(Function function, double minTime)
+{
+	typedef std::chrono::steady_clock Clock;
+
+	// Warm up caches and page tables
+	function();
+
+	double best = 1e300;
+	double total = 0;
+	unsigned int calls = 0;
+	while (total < minTime || calls < 3)
+	{
+		Clock::time_point start = Clock::now();
+		function();
+		double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+		best = std::min(best, seconds);
+		total += seconds;
+		calls++;
+	}
+
+	return best;
+}
+
+/**
+ * @brief Stores a result and prints it
+ */
+void report(std::vector<Result> &results, const std::string &name, const std::string &precision,
+	unsigned int size, unsigned long long workingSet, double seconds, double cells, double bytesPerCell)
+{
+	Result result;
+	result.name = name;
+	result.precision = precision;
+	result.size = size;
+	result.workingSet = workingSet;
+	result.seconds = seconds;
+	result.cellUpdates = cells / seconds;
+	result.bytesPerCell = bytesPerCell;
+	results.push_back(result);
+
+	tools::Logger::logger << std::left << std::setw(24) << name << std::setw(8) << precision
+		<< std::right << std::setw(10) << size
+		<< std::setw(12) << std::setprecision(4) << result.cellUpdates / 1e6 << " MCells/s"
+		<< std::setw(10) << std::setprecision(4) << result.cellUpdates * bytesPerCell / 1e9 << " GB/s"
+		<< std::endl;
+}
+
+/**
+ * @brief Times the phases of a time step on one domain size
+ */
+template<typename T, typename C> void micro(const Options &options, const std::string &precision,
+	unsigned int size, std::vector<Result> &results)
+{
+	scenarios::DamBreak<T> scenario(size);
+	Domain<T> domain(size, scenario);
+	const unsigned long long workingSet = (size+2) * (3*sizeof(T) + 4*sizeof(C));
+
+	// The scalar solver, one edge after another
+	{
+		solver::FWave<C> fwave;
+		std::vector<C> netUpdates(4*(size+1));
+		C maxWaveSpeed = 0;
+		double seconds = measure([&]() {
+			for (unsigned int i = 0; i < size+1; i++)
+			{
+				C speed;
+				fwave.computeNetUpdates(domain.h[i], domain.h[i+1], domain.hu[i], domain.hu[i+1],
+					domain.b[i], domain.b[i+1],
+					netUpdates[4*i], netUpdates[4*i+1], netUpdates[4*i+2], netUpdates[4*i+3], speed);
+				maxWaveSpeed = std::max(maxWaveSpeed, speed);
+			}
+		}, options.minTime);
+		report(results, "fwave", precision, size, workingSet, seconds, size+1,
+			3*sizeof(T) + 4*sizeof(C));
+	}
+
+	// The batched kernel on one thread
+	{
+		kernels::FWaveBatch<T, C> fwave;
+		std::vector<C> hLeft(size+1), hRight(size+1), huLeft(size+1), huRight(size+1);
+		double seconds = measure([&]() {
+			fwave.computeNetUpdates(&domain.h[0], &domain.hu[0], &domain.b[0],
+				&hLeft[0], &hRight[0], &huLeft[0], &huRight[0], 0, size+1);
+		}, options.minTime);
+		report(results, std::string("fwave_batch_") + kernels::isaName(fwave.isa()), precision,
+			size, workingSet, seconds, size+1, 3*sizeof(T) + 4*sizeof(C));
+	}
+
+	// The phases of WavePropagation
+	WavePropagation<T, C> wavePropagation(size, scenario.getCellSize(),
+		&domain.h[0], &domain.hu[0], &domain.b[0], false, options.threads);
+	wavePropagation.setOutflowBoundaryConditions();
+
+	C dt = 0;
+	double seconds = measure([&]() {
+		dt = wavePropagation.computeNumericalFluxes();
+	}, options.minTime);
+	report(results, "computeNumericalFluxes", precision, size, workingSet, seconds, size+1,
+		3*sizeof(T) + 4*sizeof(C));
+
+	// A tiny time step keeps the unknowns valid during all repetitions
+	seconds = measure([&]() {
+		wavePropagation.updateUnknowns(dt * (C) 1e-6);
+	}, options.minTime);
+	report(results, "updateUnknowns", precision, size, workingSet, seconds, size,
+		4*sizeof(T) + 4*sizeof(C));
+
+	// The froude numbers are only computed by the writers
+	writer::DerivedFields<T> derived;
+	std::vector<T> froude(size);
+	seconds = measure([&]() {
+		derived.compute(writer::DerivedFields<T>::FROUDE, domain.h, domain.hu, domain.b, 1, size+1, &froude[0]);
+	}, options.minTime);
+	report(results, "froude", precision, size, workingSet, seconds, size, 3*sizeof(T));
+
+	writer::DerivedFields<T> fastDerived(true);
+	seconds = measure([&]() {
+		fastDerived.compute(writer::DerivedFields<T>::FROUDE, domain.h, domain.hu, domain.b, 1, size+1, &froude[0]);
+	}, options.minTime);
+	report(results, "froude_fast", precision, size, workingSet, seconds, size, 3*sizeof(T));
+
+	// Velocity, celerity and froude number at once, computed with precision C
+	kernels::CellBatch<T, C> cells(true);
+	std::vector<C> velocity(size+2), celerity(size+2), cellFroude(size+2);
+	seconds = measure([&]() {
+		cells.computeCharacteristics(domain.h, domain.hu, &velocity[0], &celerity[0], &cellFroude[0], 1, size+1);
+	}, options.minTime);
+	report(results, "characteristics_fast", precision, size, workingSet, seconds, size,
+		2*sizeof(T) + 3*sizeof(C));
+
+	// Streaming the cells as CSV text, without the cost of a terminal or a pipe
+	int devNull = open("/dev/null", O_WRONLY);
+	if (devNull >= 0)
+	{
+		writer::ConsoleWriter<T> csv(scenario.getCellSize(), writer::ConsoleWriter<T>::CSV, -1,
+			options.threads, devNull);
+		seconds = measure([&]() {
+			csv.write(0, domain.h, domain.hu, domain.b, size);
+		}, options.minTime);
+		report(results, "csv", precision, size, workingSet, seconds, size, 3*sizeof(T));
+		close(devNull);
+	}
+}
+
+/**
+ * @brief Runs a scenario for a number of time steps
+ */
+template<typename T, typename C, class Scenario> void macro(const Options &options, const std::string &precision,
+	const std::string &name, std::vector<Result> &results)
+{
+	const unsigned int size = options.macroSize;
+	Scenario scenario(size);
+	Domain<T> domain(size, scenario);
+
+	WavePropagation<T, C> wavePropagation(size, scenario.getCellSize(),
+		&domain.h[0], &domain.hu[0], &domain.b[0], false, options.threads);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (unsigned int i = 0; i < options.timeSteps; i++)
+	{
+		wavePropagation.setOutflowBoundaryConditions();
+		C dt = wavePropagation.computeNumericalFluxes();
+		wavePropagation.updateUnknowns(dt);
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	report(results, "scenario_" + name, precision, size, (size+2) * (3*sizeof(T) + 4*sizeof(C)),
+		seconds, (double) size * options.timeSteps, 7*sizeof(T) + 8*sizeof(C));
+}
+
+/**
+ * @brief Runs all benchmarks with one precision
+ */
+template<typename T, typename C> void benchmark(const Options &options, const std::string &precision,
+	std::vector<Result> &results)
+{
+	for (unsigned long long size = options.minSize; size <= options.maxSize; size *= 4)
+		micro<T, C>(options, precision, size, results);
+
+	macro<T, C, scenarios::Bathtub<T> >(options, precision, "bathtub", results);
+	macro<T, C, scenarios::DamBreak<T> >(options, precision, "dambreak", results);
+	macro<T, C, scenarios::HydraulicSub<T> >(options, precision, "hydraulicsub", results);
+	macro<T, C, scenarios::HydraulicSup<T> >(options, precision, "hydraulicsup", results);
+	macro<T, C, scenarios::RareRare<T> >(options, precision, "rarerare", results);
+	macro<T, C, scenarios::ShockShock<T> >(options, precision, "shockshock", results);
+}
+
+/**
+ * @brief Writes all results as JSON
+ */
+void writeJson(const Options &options, const std::vector<Result> &results)
+{
+	std::ofstream out(options.output.c_str());
+	if (!out.good())
+		tools::Logger::logger.error(("Could not open " + options.output).c_str());
+
+	kernels::FWaveBatch<float> fwave;
+
+	out << std::setprecision(8)
+		<< "{\n"
+		<< "  \"threads\": " << options.threads << ",\n"
+		<< "  \"isa\": \"" << kernels::isaName(fwave.isa()) << "\",\n"
+		<< "  \"timeSteps\": " << options.timeSteps << ",\n"
+		<< "  \"results\": [\n";
+	for (unsigned int i = 0; i < results.size(); i++)
+	{
+		const Result &r = results[i];
+		out << "    {\"name\": \"" << r.name << "\", \"precision\": \"" << r.precision
+			<< "\", \"size\": " << r.size << ", \"workingSet\": " << r.workingSet
+			<< ", \"seconds\": " << r.seconds << ", \"cellUpdatesPerSecond\": " << r.cellUpdates
+			<< ", \"bytesPerCell\": " << r.bytesPerCell << "}"
+			<< (i+1 < results.size() ? ",\n" : "\n");
+	}
+	out << "  ]\n"
+		<< "}\n";
+}
+
+/**
+ * @brief Prints the help message
+ */
+void printHelpMessage(std::ostream &out = std::cout)
+{
+	out << "Usage: SWE1D_benchmark [OPTIONS...]" << std::endl
+		<< "  -s, --min-size=SIZE          smallest domain of the microbenchmarks (1024)" << std::endl
+		<< "  -S, --max-size=SIZE          largest domain of the microbenchmarks (4194304)" << std::endl
+		<< "  -m, --macro-size=SIZE        domain size of the scenario runs (100000)" << std::endl
+		<< "  -t, --time=TIME              time steps of the scenario runs (200)" << std::endl
+		<< "  -r, --min-time=SECONDS       minimum measurement time of a microbenchmark (0.2)" << std::endl
+		<< "  -n, --threads=NUM            number of threads" << std::endl
+		<< "  -p, --precision=PRECISION    single, double, mixed or all (default)" << std::endl
+		<< "  -o, --output=FILE            JSON output (benchmark.json)" << std::endl
+		<< "  -h, --help                   this help message" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	options.minSize = 1024;
+	options.maxSize = 1 << 22;
+	options.macroSize = 100000;
+	options.timeSteps = 200;
+	options.minTime = .2;
+	options.threads = 1;
+	options.precision = "all";
+	options.output = "benchmark.json";
+
+	const struct option longOptions[] = {
+		{"min-size", required_argument, 0, 's'},
+		{"max-size", required_argument, 0, 'S'},
+		{"macro-size", required_argument, 0, 'm'},
+		{"time", required_argument, 0, 't'},
+		{"min-time", required_argument, 0, 'r'},
+		{"threads", required_argument, 0, 'n'},
+		{"precision", required_argument, 0, 'p'},
+		{"output", required_argument, 0, 'o'},
+		{"help", no_argument, 0, 'h'},
+		{0, 0, 0, 0}
+	};
+
+	int c;
+	while ((c = getopt_long(argc, argv, "s:S:m:t:r:n:p:o:h", longOptions, 0L)) >= 0)
+	{
+		switch (c)
+		{
+		case 's':
+			options.minSize = std::atoi(optarg);
+			break;
+		case 'S':
+			options.maxSize = std::atoi(optarg);
+			break;
+		case 'm':
+			options.macroSize = std::atoi(optarg);
+			break;
+		case 't':
+			options.timeSteps = std::atoi(optarg);
+			break;
+		case 'r':
+			options.minTime = std::atof(optarg);
+			break;
+		case 'n':
+			options.threads = std::atoi(optarg);
+			break;
+		case 'p':
+			options.precision = optarg;
+			break;
+		case 'o':
+			options.output = optarg;
+			break;
+		case 'h':
+			printHelpMessage();
+			return 0;
+		default:
+			printHelpMessage(std::cerr);
+			return 1;
+		}
+	}
+
+	if (options.minSize == 0 || options.minSize > options.maxSize)
+		tools::Logger::logger.error("The domain sizes have to satisfy 0 < min-size <= max-size");
+
+	std::vector<Result> results;
+	if (options.precision == "single" || options.precision == "all")
+		benchmark<float, float>(options, "single", results);
+	if (options.precision == "double" || options.precision == "all")
+		benchmark<double, double>(options, "double", results);
+	if (options.precision == "mixed" || options.precision == "all")
+		benchmark<float, double>(options, "mixed", results);
+	if (results.empty())
+		tools::Logger::logger.error("Unknown precision");
+
+	writeJson(options, results);
+
+	return 0;
+}
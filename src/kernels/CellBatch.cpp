@@ -0,0 +1,64 @@
+/**
+ * @file CellBatch.cpp
+ * @brief Scalar kernel and runtime dispatch of kernels::CellBatch
+ */
+
+#include "CellBatch.hpp"
+#include "FWaveBatchImpl.hpp"
+
+namespace
+{
+
+	/**
+	 * @brief The portable kernel
+	 */
+	template<typename T, typename C, bool Fast> C cellsScalar(const T *h, const T *hu,
+		C *u, C *celerity, C *froude, unsigned int &i, unsigned int end)
+	{
+		return kernels::cellSweep<kernels::ScalarOps<C>, Fast>(h, hu, u, celerity, froude, i, end);
+	}
+
+	/**
+	 * @brief Selects the kernel of an instruction set
+	 */
+	template<typename T, typename C, bool Fast> typename kernels::CellBatch<T, C>::Kernel selectKernel(kernels::Isa isa)
+	{
+		switch (isa) {
+#ifdef SIMD_X86
+			case kernels::AVX512:
+				return &kernels::detail::cellsAvx512<T, C, Fast>;
+			case kernels::AVX2:
+				return &kernels::detail::cellsAvx2<T, C, Fast>;
+#endif
+			default:
+				return &cellsScalar<T, C, Fast>;
+		}
+	}
+
+}
+
+template<typename T, typename C> kernels::CellBatch<T, C>::CellBatch(bool fast, Isa isa)
+	: m_isa(isa < detectIsa() ? isa : detectIsa()), m_fast(fast)
+{
+	m_kernel = fast ? selectKernel<T, C, true>(m_isa) : selectKernel<T, C, false>(m_isa);
+	m_remainder = fast ? &cellsScalar<T, C, true> : &cellsScalar<T, C, false>;
+}
+
+template<typename T, typename C> C kernels::CellBatch<T, C>::computeCharacteristics(const T *h, const T *hu,
+	C *u, C *celerity, C *froude, unsigned int begin, unsigned int end) const
+{
+	unsigned int i = begin;
+
+	// Complete vectors
+	C maxSpeed = m_kernel(h, hu, u, celerity, froude, i, end);
+
+	// Remaining cells
+	C maxRemainderSpeed = m_remainder(h, hu, u, celerity, froude, i, end);
+
+	if (maxRemainderSpeed > maxSpeed) maxSpeed = maxRemainderSpeed;
+	return maxSpeed;
+}
+
+template class kernels::CellBatch<float>;
+template class kernels::CellBatch<double>;
+template class kernels::CellBatch<float, double>;
@@ -0,0 +1,150 @@
+/**
+ * @file FWaveBatch.cpp
+ * @brief Scalar kernel and runtime dispatch of kernels::FWaveBatch
+ */
+
+#include "FWaveBatch.hpp"
+#include "FWaveBatchImpl.hpp"
+
+namespace
+{
+
+	/**
+	 * @brief The portable kernel
+	 */
+	template<typename T, typename C> C fwaveScalar(const T *h, const T *hu, const T *b,
+		C *hNetUpdatesLeft, C *hNetUpdatesRight,
+		C *huNetUpdatesLeft, C *huNetUpdatesRight,
+		C *waveSpeeds, unsigned int &i, unsigned int end, unsigned int stride)
+	{
+		return kernels::fwaveSweep<kernels::ScalarOps<C> >(h, hu, b,
+			hNetUpdatesLeft, hNetUpdatesRight,
+			huNetUpdatesLeft, huNetUpdatesRight,
+			waveSpeeds, i, end, stride);
+	}
+
+	/**
+	 * @brief The portable wave speed kernel
+	 */
+	template<typename T, typename C> C maxWaveSpeedScalar(const T *h, const T *hu, const T *b,
+		unsigned int &i, unsigned int end)
+	{
+		return kernels::maxWaveSpeedSweep<kernels::ScalarOps<C> >(h, hu, b, i, end);
+	}
+
+	/**
+	 * @brief Selects the kernel of an instruction set
+	 */
+	template<typename T, typename C> typename kernels::FWaveBatch<T, C>::Kernel selectKernel(kernels::Isa isa)
+	{
+		switch (isa) {
+#ifdef SIMD_X86
+			case kernels::AVX512:
+				return &kernels::detail::fwaveAvx512<T, C>;
+			case kernels::AVX2:
+				return &kernels::detail::fwaveAvx2<T, C>;
+#endif
+			default:
+				return &fwaveScalar<T, C>;
+		}
+	}
+
+	/**
+	 * @brief Selects the wave speed kernel of an instruction set
+	 */
+	template<typename T, typename C> typename kernels::FWaveBatch<T, C>::SpeedKernel selectSpeedKernel(kernels::Isa isa)
+	{
+		switch (isa) {
+#ifdef SIMD_X86
+			case kernels::AVX512:
+				return &kernels::detail::maxWaveSpeedAvx512<T, C>;
+			case kernels::AVX2:
+				return &kernels::detail::maxWaveSpeedAvx2<T, C>;
+#endif
+			default:
+				return &maxWaveSpeedScalar<T, C>;
+		}
+	}
+
+}
+
+kernels::Isa kernels::detectIsa()
+{
+#ifdef SIMD_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f"))
+		return AVX512;
+	if (__builtin_cpu_supports("avx2"))
+		return AVX2;
+#endif
+	return SCALAR;
+}
+
+const char* kernels::isaName(Isa isa)
+{
+	switch (isa) {
+		case AVX512:
+			return "AVX-512";
+		case AVX2:
+			return "AVX2";
+		default:
+			return "scalar";
+	}
+}
+
+template<typename T, typename C> kernels::FWaveBatch<T, C>::FWaveBatch(Isa isa)
+	: m_isa(isa < detectIsa() ? isa : detectIsa())
+{
+	m_kernel = selectKernel<T, C>(m_isa);
+	m_speedKernel = selectSpeedKernel<T, C>(m_isa);
+}
+
+template<typename T, typename C> C kernels::FWaveBatch<T, C>::computeNetUpdates(const T *h, const T *hu, const T *b,
+	C *hNetUpdatesLeft, C *hNetUpdatesRight,
+	C *huNetUpdatesLeft, C *huNetUpdatesRight,
+	unsigned int begin, unsigned int end) const
+{
+	return computeNetUpdates(h, hu, b,
+		hNetUpdatesLeft, hNetUpdatesRight,
+		huNetUpdatesLeft, huNetUpdatesRight,
+		0L, begin, end, 1);
+}
+
+template<typename T, typename C> C kernels::FWaveBatch<T, C>::computeNetUpdates(const T *h, const T *hu, const T *b,
+	C *hNetUpdatesLeft, C *hNetUpdatesRight,
+	C *huNetUpdatesLeft, C *huNetUpdatesRight,
+	C *waveSpeeds, unsigned int begin, unsigned int end, unsigned int stride) const
+{
+	unsigned int i = begin;
+
+	// Complete vectors
+	C maxWaveSpeed = m_kernel(h, hu, b,
+		hNetUpdatesLeft, hNetUpdatesRight,
+		huNetUpdatesLeft, huNetUpdatesRight,
+		waveSpeeds, i, end, stride);
+
+	// Remaining edges
+	C maxRemainderSpeed = fwaveScalar(h, hu, b,
+		hNetUpdatesLeft, hNetUpdatesRight,
+		huNetUpdatesLeft, huNetUpdatesRight,
+		waveSpeeds, i, end, stride);
+
+	if (maxRemainderSpeed > maxWaveSpeed) maxWaveSpeed = maxRemainderSpeed;
+	return maxWaveSpeed;
+}
+
+template<typename T, typename C> C kernels::FWaveBatch<T, C>::computeMaxWaveSpeed(const T *h, const T *hu, const T *b,
+	unsigned int begin, unsigned int end) const
+{
+	unsigned int i = begin;
+
+	C maxWaveSpeed = m_speedKernel(h, hu, b, i, end);
+	C maxRemainderSpeed = maxWaveSpeedScalar<T, C>(h, hu, b, i, end);
+
+	if (maxRemainderSpeed > maxWaveSpeed) maxWaveSpeed = maxRemainderSpeed;
+	return maxWaveSpeed;
+}
+
+template class kernels::FWaveBatch<float>;
+template class kernels::FWaveBatch<double>;
+template class kernels::FWaveBatch<float, double>;
@@ -0,0 +1,157 @@
+/**
+ * @file FWaveBatch.hpp
+ * @brief Batched f-wave kernel working directly on the unknown arrays
+ */
+
+#ifndef KERNELS_FWAVEBATCH_H_
+#define KERNELS_FWAVEBATCH_H_
+
+/**
+ * @brief Vectorized compute kernels of the framework
+ */
+namespace kernels
+{
+
+	/** @brief Instruction sets the batched kernels are available for */
+	enum Isa { SCALAR, AVX2, AVX512 };
+
+	/**
+	 * @brief Detects the best instruction set supported by the running CPU
+	 *
+	 * @return The widest instruction set that is compiled in and supported
+	 */
+	Isa detectIsa();
+
+	/**
+	 * @brief Returns a human readable name of an instruction set
+	 *
+	 * @param isa The instruction set
+	 *
+	 * @return The name of the instruction set
+	 */
+	const char* isaName(Isa isa);
+
+	/**
+	 * @brief Computes f-wave net-updates for many edges at once
+	 *
+	 * Implements the same f-wave formulation as solver::FWave (Einfeldt speeds, reflecting
+	 * walls at wet/dry edges) but reads the unknowns straight from the arrays and processes
+	 * 8 (AVX2) or 16 (AVX-512) single precision edges per iteration. The instruction set is
+	 * picked at runtime, the remaining edges are handled by the portable scalar kernel.
+	 *
+	 * The edge with index i is located between the cells i and i+1,
+	 * see WavePropagation for the layout of the net-updates.
+	 *
+	 * The unknowns are stored with precision T, the net-updates and wave speeds are
+	 * computed and returned with precision C (float/float, double/double or float/double).
+	 */
+	template<typename T, typename C = T> class FWaveBatch
+	{
+
+		public:
+
+			/** @brief Signature of an instruction set specific kernel */
+			typedef C (*Kernel)(const T *h, const T *hu, const T *b,
+				C *hNetUpdatesLeft, C *hNetUpdatesRight,
+				C *huNetUpdatesLeft, C *huNetUpdatesRight,
+				C *waveSpeeds, unsigned int &i, unsigned int end, unsigned int stride);
+
+			/** @brief Signature of an instruction set specific wave speed kernel */
+			typedef C (*SpeedKernel)(const T *h, const T *hu, const T *b,
+				unsigned int &i, unsigned int end);
+
+		private:
+
+			/** @brief The instruction set in use */
+			Isa m_isa;
+
+			/** @brief The vectorized kernel, only processes complete vectors */
+			Kernel m_kernel;
+
+			/** @brief The vectorized wave speed kernel, only processes complete vectors */
+			SpeedKernel m_speedKernel;
+
+		public:
+
+			/**
+			 * @brief Constructor
+			 *
+			 * @param isa The requested instruction set, falls back to a supported one
+			 */
+			FWaveBatch(Isa isa = detectIsa());
+
+			/**
+			 * @brief Computes the net-updates for the edges [begin, end)
+			 *
+			 * @param[in] h The water heights
+			 * @param[in] hu The water fluxes
+			 * @param[in] b The bathymetries
+			 * @param[out] hNetUpdatesLeft The left going net-updates for the water height
+			 * @param[out] hNetUpdatesRight The right going net-updates for the water height
+			 * @param[out] huNetUpdatesLeft The left going net-updates for the water flux
+			 * @param[out] huNetUpdatesRight The right going net-updates for the water flux
+			 * @param begin The first edge
+			 * @param end One past the last edge
+			 *
+			 * @return The maximum wave speed of all edges
+			 */
+			C computeNetUpdates(const T *h, const T *hu, const T *b,
+				C *hNetUpdatesLeft, C *hNetUpdatesRight,
+				C *huNetUpdatesLeft, C *huNetUpdatesRight,
+				unsigned int begin, unsigned int end) const;
+
+			/**
+			 * @brief Computes the net-updates for the edges [begin, end) of interleaved domains
+			 *
+			 * The right cell of edge i is i+stride, so several domains stored
+			 * cell-major (the values of all domains for one cell next to each other)
+			 * are processed as one long run of edges.
+			 *
+			 * @param[in] h The water heights
+			 * @param[in] hu The water fluxes
+			 * @param[in] b The bathymetries
+			 * @param[out] hNetUpdatesLeft The left going net-updates for the water height
+			 * @param[out] hNetUpdatesRight The right going net-updates for the water height
+			 * @param[out] huNetUpdatesLeft The left going net-updates for the water flux
+			 * @param[out] huNetUpdatesRight The right going net-updates for the water flux
+			 * @param[out] waveSpeeds The wave speed of every edge, not written if null
+			 * @param begin The first edge
+			 * @param end One past the last edge
+			 * @param stride Distance between the left and the right cell of an edge
+			 *
+			 * @return The maximum wave speed of all edges
+			 */
+			C computeNetUpdates(const T *h, const T *hu, const T *b,
+				C *hNetUpdatesLeft, C *hNetUpdatesRight,
+				C *huNetUpdatesLeft, C *huNetUpdatesRight,
+				C *waveSpeeds, unsigned int begin, unsigned int end, unsigned int stride) const;
+
+			/**
+			 * @brief Computes the maximum wave speed of the edges [begin, end)
+			 *
+			 * Gives the same result as computeNetUpdates, without computing the net-updates.
+			 *
+			 * @param h The water heights
+			 * @param hu The water fluxes
+			 * @param b The bathymetries
+			 * @param begin The first edge
+			 * @param end One past the last edge
+			 *
+			 * @return The maximum wave speed of all edges
+			 */
+			C computeMaxWaveSpeed(const T *h, const T *hu, const T *b,
+				unsigned int begin, unsigned int end) const;
+
+			/**
+			 * @brief The instruction set in use
+			 */
+			Isa isa() const
+			{
+				return m_isa;
+			}
+
+	};
+
+}
+
+#endif /* KERNELS_FWAVEBATCH_H_ */
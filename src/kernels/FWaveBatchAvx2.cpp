@@ -0,0 +1,162 @@
+/**
+ * @file FWaveBatchAvx2.cpp
+ * @brief AVX2 version of the batched f-wave kernel
+ *
+ * Has to be compiled with -mavx2, it is only called if the CPU supports AVX2.
+ */
+
+#include <immintrin.h>
+#include "FWaveBatchImpl.hpp"
+
+namespace
+{
+
+	/**
+	 * @brief AVX2 operations on 8 floats
+	 */
+	struct Avx2Float
+	{
+		typedef float Scalar;
+		typedef __m256 Vec;
+		typedef __m256 Mask;
+
+		static const unsigned int width = 8;
+
+		/** @brief Correct bits of rsqrt (relative error below 1.5 * 2^-12) */
+		static const unsigned int rsqrtBits = 11;
+
+		static Vec load(const float *p) { return _mm256_loadu_ps(p); }
+		static void store(float *p, Vec a) { _mm256_storeu_ps(p, a); }
+		static Vec set1(float a) { return _mm256_set1_ps(a); }
+
+		static Vec add(Vec a, Vec b) { return _mm256_add_ps(a, b); }
+		static Vec sub(Vec a, Vec b) { return _mm256_sub_ps(a, b); }
+		static Vec mul(Vec a, Vec b) { return _mm256_mul_ps(a, b); }
+		static Vec div(Vec a, Vec b) { return _mm256_div_ps(a, b); }
+		static Vec sqrt(Vec a) { return _mm256_sqrt_ps(a); }
+		static Vec rsqrt(Vec a) { return _mm256_rsqrt_ps(a); }
+		static Vec min(Vec a, Vec b) { return _mm256_min_ps(a, b); }
+		static Vec max(Vec a, Vec b) { return _mm256_max_ps(a, b); }
+		static Vec neg(Vec a) { return _mm256_xor_ps(a, _mm256_set1_ps(-0.f)); }
+		static Vec abs(Vec a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a); }
+
+		static Mask lt(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+		static Mask andMask(Mask a, Mask b) { return _mm256_and_ps(a, b); }
+		static Mask andNotMask(Mask a, Mask b) { return _mm256_andnot_ps(a, b); }
+		static Vec select(Mask m, Vec a, Vec b) { return _mm256_blendv_ps(b, a, m); }
+
+		static float reduceMax(Vec a)
+		{
+			__m128 m = _mm_max_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+			m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+			m = _mm_max_ss(m, _mm_shuffle_ps(m, m, 1));
+			return _mm_cvtss_f32(m);
+		}
+	};
+
+	/**
+	 * @brief AVX2 operations on 4 doubles
+	 */
+	struct Avx2Double
+	{
+		typedef double Scalar;
+		typedef __m256d Vec;
+		typedef __m256d Mask;
+
+		static const unsigned int width = 4;
+
+		/** @brief Correct bits of rsqrt (single precision approximation) */
+		static const unsigned int rsqrtBits = 11;
+
+		static Vec load(const double *p) { return _mm256_loadu_pd(p); }
+		static Vec load(const float *p) { return _mm256_cvtps_pd(_mm_loadu_ps(p)); }
+		static void store(double *p, Vec a) { _mm256_storeu_pd(p, a); }
+		static Vec set1(double a) { return _mm256_set1_pd(a); }
+
+		static Vec add(Vec a, Vec b) { return _mm256_add_pd(a, b); }
+		static Vec sub(Vec a, Vec b) { return _mm256_sub_pd(a, b); }
+		static Vec mul(Vec a, Vec b) { return _mm256_mul_pd(a, b); }
+		static Vec div(Vec a, Vec b) { return _mm256_div_pd(a, b); }
+		static Vec sqrt(Vec a) { return _mm256_sqrt_pd(a); }
+		static Vec rsqrt(Vec a)
+		{
+			// AVX2 has no double precision approximation, only for values in the range of float
+			return _mm256_cvtps_pd(_mm_rsqrt_ps(_mm256_cvtpd_ps(a)));
+		}
+		static Vec min(Vec a, Vec b) { return _mm256_min_pd(a, b); }
+		static Vec max(Vec a, Vec b) { return _mm256_max_pd(a, b); }
+		static Vec neg(Vec a) { return _mm256_xor_pd(a, _mm256_set1_pd(-0.)); }
+		static Vec abs(Vec a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.), a); }
+
+		static Mask lt(Vec a, Vec b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+		static Mask andMask(Mask a, Mask b) { return _mm256_and_pd(a, b); }
+		static Mask andNotMask(Mask a, Mask b) { return _mm256_andnot_pd(a, b); }
+		static Vec select(Mask m, Vec a, Vec b) { return _mm256_blendv_pd(b, a, m); }
+
+		static double reduceMax(Vec a)
+		{
+			__m128d m = _mm_max_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1));
+			m = _mm_max_sd(m, _mm_unpackhi_pd(m, m));
+			return _mm_cvtsd_f64(m);
+		}
+	};
+
+	/**
+	 * @brief Selects the operations for a precision
+	 */
+	template<typename C> struct Avx2Ops;
+	template<> struct Avx2Ops<float> { typedef Avx2Float Type; };
+	template<> struct Avx2Ops<double> { typedef Avx2Double Type; };
+
+}
+
+template<typename T, typename C> C kernels::detail::fwaveAvx2(const T *h, const T *hu, const T *b,
+	C *hNetUpdatesLeft, C *hNetUpdatesRight,
+	C *huNetUpdatesLeft, C *huNetUpdatesRight,
+	C *waveSpeeds, unsigned int &i, unsigned int end, unsigned int stride)
+{
+	return fwaveSweep<typename Avx2Ops<C>::Type>(h, hu, b,
+		hNetUpdatesLeft, hNetUpdatesRight,
+		huNetUpdatesLeft, huNetUpdatesRight,
+		waveSpeeds, i, end, stride);
+}
+
+template<typename T, typename C> C kernels::detail::maxWaveSpeedAvx2(const T *h, const T *hu, const T *b,
+	unsigned int &i, unsigned int end)
+{
+	return maxWaveSpeedSweep<typename Avx2Ops<C>::Type>(h, hu, b, i, end);
+}
+
+template<typename T, typename C, bool Fast> C kernels::detail::cellsAvx2(const T *h, const T *hu,
+	C *u, C *celerity, C *froude, unsigned int &i, unsigned int end)
+{
+	return cellSweep<typename Avx2Ops<C>::Type, Fast>(h, hu, u, celerity, froude, i, end);
+}
+
+// Single, double and mixed precision
+template float kernels::detail::fwaveAvx2<float, float>(const float*, const float*, const float*,
+	float*, float*, float*, float*, float*, unsigned int&, unsigned int, unsigned int);
+template double kernels::detail::fwaveAvx2<double, double>(const double*, const double*, const double*,
+	double*, double*, double*, double*, double*, unsigned int&, unsigned int, unsigned int);
+template double kernels::detail::fwaveAvx2<float, double>(const float*, const float*, const float*,
+	double*, double*, double*, double*, double*, unsigned int&, unsigned int, unsigned int);
+
+template float kernels::detail::maxWaveSpeedAvx2<float, float>(const float*, const float*, const float*,
+	unsigned int&, unsigned int);
+template double kernels::detail::maxWaveSpeedAvx2<double, double>(const double*, const double*, const double*,
+	unsigned int&, unsigned int);
+template double kernels::detail::maxWaveSpeedAvx2<float, double>(const float*, const float*, const float*,
+	unsigned int&, unsigned int);
+
+template float kernels::detail::cellsAvx2<float, float, false>(const float*, const float*,
+	float*, float*, float*, unsigned int&, unsigned int);
+template double kernels::detail::cellsAvx2<double, double, false>(const double*, const double*,
+	double*, double*, double*, unsigned int&, unsigned int);
+template double kernels::detail::cellsAvx2<float, double, false>(const float*, const float*,
+	double*, double*, double*, unsigned int&, unsigned int);
+template float kernels::detail::cellsAvx2<float, float, true>(const float*, const float*,
+	float*, float*, float*, unsigned int&, unsigned int);
+template double kernels::detail::cellsAvx2<double, double, true>(const double*, const double*,
+	double*, double*, double*, unsigned int&, unsigned int);
+template double kernels::detail::cellsAvx2<float, double, true>(const float*, const float*,
+	double*, double*, double*, unsigned int&, unsigned int);
@@ -0,0 +1,157 @@
+/**
+ * @file FWaveBatchAvx512.cpp
+ * @brief AVX-512 version of the batched f-wave kernel
+ *
+ * Has to be compiled with -mavx512f, it is only called if the CPU supports AVX-512F.
+ */
+
+#include <immintrin.h>
+#include "FWaveBatchImpl.hpp"
+
+namespace
+{
+
+	/**
+	 * @brief AVX-512 operations on 16 floats
+	 */
+	struct Avx512Float
+	{
+		typedef float Scalar;
+		typedef __m512 Vec;
+		typedef __mmask16 Mask;
+
+		static const unsigned int width = 16;
+
+		/** @brief Correct bits of rsqrt (relative error below 2^-14) */
+		static const unsigned int rsqrtBits = 14;
+
+		static Vec load(const float *p) { return _mm512_loadu_ps(p); }
+		static void store(float *p, Vec a) { _mm512_storeu_ps(p, a); }
+		static Vec set1(float a) { return _mm512_set1_ps(a); }
+
+		static Vec add(Vec a, Vec b) { return _mm512_add_ps(a, b); }
+		static Vec sub(Vec a, Vec b) { return _mm512_sub_ps(a, b); }
+		static Vec mul(Vec a, Vec b) { return _mm512_mul_ps(a, b); }
+		static Vec div(Vec a, Vec b) { return _mm512_div_ps(a, b); }
+		static Vec sqrt(Vec a) { return _mm512_sqrt_ps(a); }
+		static Vec rsqrt(Vec a) { return _mm512_rsqrt14_ps(a); }
+		static Vec min(Vec a, Vec b) { return _mm512_min_ps(a, b); }
+		static Vec max(Vec a, Vec b) { return _mm512_max_ps(a, b); }
+		static Vec neg(Vec a)
+		{
+			// AVX-512F has no floating point xor
+			return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a),
+				_mm512_set1_epi32(0x80000000)));
+		}
+		static Vec abs(Vec a) { return _mm512_abs_ps(a); }
+
+		static Mask lt(Vec a, Vec b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+		static Mask andMask(Mask a, Mask b) { return a & b; }
+		static Mask andNotMask(Mask a, Mask b) { return ~a & b; }
+		static Vec select(Mask m, Vec a, Vec b) { return _mm512_mask_blend_ps(m, b, a); }
+
+		static float reduceMax(Vec a) { return _mm512_reduce_max_ps(a); }
+	};
+
+	/**
+	 * @brief AVX-512 operations on 8 doubles
+	 */
+	struct Avx512Double
+	{
+		typedef double Scalar;
+		typedef __m512d Vec;
+		typedef __mmask8 Mask;
+
+		static const unsigned int width = 8;
+
+		/** @brief Correct bits of rsqrt (relative error below 2^-14) */
+		static const unsigned int rsqrtBits = 14;
+
+		static Vec load(const double *p) { return _mm512_loadu_pd(p); }
+		static Vec load(const float *p) { return _mm512_cvtps_pd(_mm256_loadu_ps(p)); }
+		static void store(double *p, Vec a) { _mm512_storeu_pd(p, a); }
+		static Vec set1(double a) { return _mm512_set1_pd(a); }
+
+		static Vec add(Vec a, Vec b) { return _mm512_add_pd(a, b); }
+		static Vec sub(Vec a, Vec b) { return _mm512_sub_pd(a, b); }
+		static Vec mul(Vec a, Vec b) { return _mm512_mul_pd(a, b); }
+		static Vec div(Vec a, Vec b) { return _mm512_div_pd(a, b); }
+		static Vec sqrt(Vec a) { return _mm512_sqrt_pd(a); }
+		static Vec rsqrt(Vec a) { return _mm512_rsqrt14_pd(a); }
+		static Vec min(Vec a, Vec b) { return _mm512_min_pd(a, b); }
+		static Vec max(Vec a, Vec b) { return _mm512_max_pd(a, b); }
+		static Vec neg(Vec a)
+		{
+			// AVX-512F has no floating point xor
+			return _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(a),
+				_mm512_set1_epi64(0x8000000000000000ll)));
+		}
+		static Vec abs(Vec a) { return _mm512_abs_pd(a); }
+
+		static Mask lt(Vec a, Vec b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+		static Mask andMask(Mask a, Mask b) { return a & b; }
+		static Mask andNotMask(Mask a, Mask b) { return ~a & b; }
+		static Vec select(Mask m, Vec a, Vec b) { return _mm512_mask_blend_pd(m, b, a); }
+
+		static double reduceMax(Vec a) { return _mm512_reduce_max_pd(a); }
+	};
+
+	/**
+	 * @brief Selects the operations for a precision
+	 */
+	template<typename C> struct Avx512Ops;
+	template<> struct Avx512Ops<float> { typedef Avx512Float Type; };
+	template<> struct Avx512Ops<double> { typedef Avx512Double Type; };
+
+}
+
+template<typename T, typename C> C kernels::detail::fwaveAvx512(const T *h, const T *hu, const T *b,
+	C *hNetUpdatesLeft, C *hNetUpdatesRight,
+	C *huNetUpdatesLeft, C *huNetUpdatesRight,
+	C *waveSpeeds, unsigned int &i, unsigned int end, unsigned int stride)
+{
+	return fwaveSweep<typename Avx512Ops<C>::Type>(h, hu, b,
+		hNetUpdatesLeft, hNetUpdatesRight,
+		huNetUpdatesLeft, huNetUpdatesRight,
+		waveSpeeds, i, end, stride);
+}
+
+template<typename T, typename C> C kernels::detail::maxWaveSpeedAvx512(const T *h, const T *hu, const T *b,
+	unsigned int &i, unsigned int end)
+{
+	return maxWaveSpeedSweep<typename Avx512Ops<C>::Type>(h, hu, b, i, end);
+}
+
+template<typename T, typename C, bool Fast> C kernels::detail::cellsAvx512(const T *h, const T *hu,
+	C *u, C *celerity, C *froude, unsigned int &i, unsigned int end)
+{
+	return cellSweep<typename Avx512Ops<C>::Type, Fast>(h, hu, u, celerity, froude, i, end);
+}
+
+// Single, double and mixed precision
+template float kernels::detail::fwaveAvx512<float, float>(const float*, const float*, const float*,
+	float*, float*, float*, float*, float*, unsigned int&, unsigned int, unsigned int);
+template double kernels::detail::fwaveAvx512<double, double>(const double*, const double*, const double*,
+	double*, double*, double*, double*, double*, unsigned int&, unsigned int, unsigned int);
+template double kernels::detail::fwaveAvx512<float, double>(const float*, const float*, const float*,
+	double*, double*, double*, double*, double*, unsigned int&, unsigned int, unsigned int);
+
+template float kernels::detail::maxWaveSpeedAvx512<float, float>(const float*, const float*, const float*,
+	unsigned int&, unsigned int);
+template double kernels::detail::maxWaveSpeedAvx512<double, double>(const double*, const double*, const double*,
+	unsigned int&, unsigned int);
+template double kernels::detail::maxWaveSpeedAvx512<float, double>(const float*, const float*, const float*,
+	unsigned int&, unsigned int);
+
+template float kernels::detail::cellsAvx512<float, float, false>(const float*, const float*,
+	float*, float*, float*, unsigned int&, unsigned int);
+template double kernels::detail::cellsAvx512<double, double, false>(const double*, const double*,
+	double*, double*, double*, unsigned int&, unsigned int);
+template double kernels::detail::cellsAvx512<float, double, false>(const float*, const float*,
+	double*, double*, double*, unsigned int&, unsigned int);
+template float kernels::detail::cellsAvx512<float, float, true>(const float*, const float*,
+	float*, float*, float*, unsigned int&, unsigned int);
+template double kernels::detail::cellsAvx512<double, double, true>(const double*, const double*,
+	double*, double*, double*, unsigned int&, unsigned int);
+template double kernels::detail::cellsAvx512<float, double, true>(const float*, const float*,
+	double*, double*, double*, unsigned int&, unsigned int);
@@ -0,0 +1,360 @@
+/**
+ * @file FWaveBatchImpl.hpp
+ * @brief Instruction set independent bodies of the batched kernels (f-wave and cell quantities)
+ *
+ * This header is included by the translation units of each instruction set. They are
+ * compiled with different target flags, so everything in here has internal linkage.
+ * Otherwise the linker could pick an AVX instantiation for the scalar code path.
+ */
+
+#ifndef KERNELS_FWAVEBATCHIMPL_H_
+#define KERNELS_FWAVEBATCHIMPL_H_
+
+#include <cmath>
+#include <limits>
+#include "FWaveConstants.hpp"
+
+namespace kernels
+{
+
+	/**
+	 * @brief Entry points of the instruction set specific translation units
+	 */
+	namespace detail
+	{
+
+		/**
+		 * @brief Computes the net-updates for complete vectors of edges (AVX2)
+		 *
+		 * Reads the unknowns with precision T and computes with precision C.
+		 */
+		template<typename T, typename C> C fwaveAvx2(const T *h, const T *hu, const T *b,
+			C *hNetUpdatesLeft, C *hNetUpdatesRight,
+			C *huNetUpdatesLeft, C *huNetUpdatesRight,
+			C *waveSpeeds, unsigned int &i, unsigned int end, unsigned int stride);
+
+		/**
+		 * @brief Computes the maximum wave speed for complete vectors of edges (AVX2)
+		 */
+		template<typename T, typename C> C maxWaveSpeedAvx2(const T *h, const T *hu, const T *b,
+			unsigned int &i, unsigned int end);
+
+		/**
+		 * @brief Computes the net-updates for complete vectors of edges (AVX-512)
+		 */
+		template<typename T, typename C> C fwaveAvx512(const T *h, const T *hu, const T *b,
+			C *hNetUpdatesLeft, C *hNetUpdatesRight,
+			C *huNetUpdatesLeft, C *huNetUpdatesRight,
+			C *waveSpeeds, unsigned int &i, unsigned int end, unsigned int stride);
+
+		/**
+		 * @brief Computes the maximum wave speed for complete vectors of edges (AVX-512)
+		 */
+		template<typename T, typename C> C maxWaveSpeedAvx512(const T *h, const T *hu, const T *b,
+			unsigned int &i, unsigned int end);
+
+		/**
+		 * @brief Computes the cell quantities for complete vectors of cells (AVX2), see kernels::CellBatch
+		 */
+		template<typename T, typename C, bool Fast> C cellsAvx2(const T *h, const T *hu,
+			C *u, C *celerity, C *froude, unsigned int &i, unsigned int end);
+
+		/**
+		 * @brief Computes the cell quantities for complete vectors of cells (AVX-512), see kernels::CellBatch
+		 */
+		template<typename T, typename C, bool Fast> C cellsAvx512(const T *h, const T *hu,
+			C *u, C *celerity, C *froude, unsigned int &i, unsigned int end);
+
+	}
+
+	namespace
+	{
+
+		/**
+		 * @brief Scalar "vector" operations, used for the portable kernels and the remainder
+		 */
+		template<typename T> struct ScalarOps
+		{
+			typedef T Scalar;
+			typedef T Vec;
+			typedef bool Mask;
+
+			static const unsigned int width = 1;
+
+			/** @brief Correct bits of rsqrt, it is exact */
+			static const unsigned int rsqrtBits = 64;
+
+			template<typename In> static Vec load(const In *p) { return *p; }
+			static void store(T *p, Vec a) { *p = a; }
+			static Vec set1(T a) { return a; }
+
+			static Vec add(Vec a, Vec b) { return a + b; }
+			static Vec sub(Vec a, Vec b) { return a - b; }
+			static Vec mul(Vec a, Vec b) { return a * b; }
+			static Vec div(Vec a, Vec b) { return a / b; }
+			static Vec sqrt(Vec a) { return std::sqrt(a); }
+			static Vec rsqrt(Vec a) { return 1 / std::sqrt(a); }
+			static Vec min(Vec a, Vec b) { return a < b ? a : b; }
+			static Vec max(Vec a, Vec b) { return a > b ? a : b; }
+			static Vec neg(Vec a) { return -a; }
+			static Vec abs(Vec a) { return std::fabs(a); }
+
+			static Mask lt(Vec a, Vec b) { return a < b; }
+			static Mask andMask(Mask a, Mask b) { return a && b; }
+			static Mask andNotMask(Mask a, Mask b) { return !a && b; }
+			static Vec select(Mask m, Vec a, Vec b) { return m ? a : b; }
+
+			static T reduceMax(Vec a) { return a; }
+		};
+
+		/**
+		 * @brief Computes net-updates for complete vectors of edges
+		 *
+		 * The vector operations are provided by V, which defines the types Scalar, Vec and Mask,
+		 * the vector width and the usual arithmetic, compare and select functions.
+		 * The unknowns may have a lower precision (In) than V::Scalar, V::load converts them.
+		 * If NetUpdates is false, only the wave speeds are computed and the net-update
+		 * arrays are not accessed.
+		 *
+		 * @param[out] waveSpeeds The wave speed of each edge, not written if null
+		 * @param[in,out] i The first edge, set to the first edge that was not processed
+		 * @param end One past the last edge
+		 * @param stride Distance between the left and the right cell of an edge
+		 *
+		 * @return The maximum wave speed of the processed edges
+		 */
+		template<class V, bool NetUpdates, typename In> typename V::Scalar fwaveSweep(const In *h,
+			const In *hu, const In *b,
+			typename V::Scalar *hNetUpdatesLeft, typename V::Scalar *hNetUpdatesRight,
+			typename V::Scalar *huNetUpdatesLeft, typename V::Scalar *huNetUpdatesRight,
+			typename V::Scalar *waveSpeeds, unsigned int &i, unsigned int end, unsigned int stride)
+		{
+			typedef typename V::Scalar S;
+			typedef typename V::Vec Vec;
+			typedef typename V::Mask Mask;
+
+			const S gravity = FWaveConstants::GRAVITY;
+			const Vec dryTol = V::set1(FWaveConstants::DRY_TOLERANCE);
+			const Vec zeroTol = V::set1(FWaveConstants::ZERO_TOLERANCE);
+			const Vec minusZeroTol = V::set1(-FWaveConstants::ZERO_TOLERANCE);
+
+			const Vec zero = V::set1(0);
+			const Vec half = V::set1(.5);
+			const Vec one = V::set1(1);
+			const Vec halfGravity = V::set1((S) .5 * gravity);
+			const Vec sqrtGravity = V::sqrt(V::set1(gravity));
+
+			Vec maxWaveSpeed = zero;
+
+			for (; i + V::width <= end; i += V::width)
+			{
+				Vec hLeft = V::load(h+i);
+				Vec hRight = V::load(h+i+stride);
+				Vec huLeft = V::load(hu+i);
+				Vec huRight = V::load(hu+i+stride);
+				Vec bLeft = V::load(b+i);
+				Vec bRight = V::load(b+i+stride);
+
+				// A dry cell next to a wet one is replaced by a reflecting wall
+				Mask dryLeft = V::lt(hLeft, dryTol);
+				Mask dryRight = V::lt(hRight, dryTol);
+				Mask dryDry = V::andMask(dryLeft, dryRight);
+				Mask wallLeft = V::andNotMask(dryRight, dryLeft);
+				Mask wallRight = V::andNotMask(dryLeft, dryRight);
+
+				hLeft = V::select(wallLeft, hRight, hLeft);
+				huLeft = V::select(wallLeft, V::neg(huRight), huLeft);
+				bLeft = V::select(wallLeft, bRight, bLeft);
+				hRight = V::select(wallRight, hLeft, hRight);
+				huRight = V::select(wallRight, V::neg(huLeft), huRight);
+				bRight = V::select(wallRight, bLeft, bRight);
+
+				// Keep dry-dry lanes finite, they are masked out below
+				hLeft = V::select(dryDry, one, hLeft);
+				hRight = V::select(dryDry, one, hRight);
+
+				Vec uLeft = V::div(huLeft, hLeft);
+				Vec uRight = V::div(huRight, hRight);
+				Vec sqrtHLeft = V::sqrt(hLeft);
+				Vec sqrtHRight = V::sqrt(hRight);
+
+				// Einfeldt speeds from the characteristic and the Roe speeds
+				Vec hRoe = V::mul(half, V::add(hLeft, hRight));
+				Vec uRoe = V::div(V::add(V::mul(uLeft, sqrtHLeft), V::mul(uRight, sqrtHRight)),
+					V::add(sqrtHLeft, sqrtHRight));
+				Vec cRoe = V::mul(sqrtGravity, V::sqrt(hRoe));
+				Vec speed0 = V::min(V::sub(uLeft, V::mul(sqrtGravity, sqrtHLeft)), V::sub(uRoe, cRoe));
+				Vec speed1 = V::max(V::add(uRight, V::mul(sqrtGravity, sqrtHRight)), V::add(uRoe, cRoe));
+
+				if (NetUpdates)
+				{
+					// Flux difference including the bathymetry source term
+					Vec fDif0 = V::sub(huRight, huLeft);
+					Vec fDif1 = V::sub(
+						V::add(V::mul(huRight, uRight), V::mul(V::mul(halfGravity, hRight), hRight)),
+						V::add(V::mul(huLeft, uLeft), V::mul(V::mul(halfGravity, hLeft), hLeft)));
+					fDif1 = V::add(fDif1, V::mul(V::mul(halfGravity, V::add(hRight, hLeft)), V::sub(bRight, bLeft)));
+
+					// Decompose into the two f-waves
+					Vec lambdaDif = V::sub(speed1, speed0);
+					Vec beta0 = V::div(V::sub(V::mul(speed1, fDif0), fDif1), lambdaDif);
+					Vec beta1 = V::div(V::sub(fDif1, V::mul(speed0, fDif0)), lambdaDif);
+
+					// Share of each wave going to the left, waves with zero speed are split in half
+					Vec left0 = V::select(V::lt(speed0, minusZeroTol), one, V::select(V::lt(zeroTol, speed0), zero, half));
+					Vec left1 = V::select(V::lt(speed1, minusZeroTol), one, V::select(V::lt(zeroTol, speed1), zero, half));
+					Vec right0 = V::sub(one, left0);
+					Vec right1 = V::sub(one, left1);
+
+					Vec flux0 = V::mul(beta0, speed0);
+					Vec flux1 = V::mul(beta1, speed1);
+
+					// Walls do not update the dry side
+					V::store(hNetUpdatesLeft+i, V::select(dryLeft, zero,
+						V::add(V::mul(left0, beta0), V::mul(left1, beta1))));
+					V::store(hNetUpdatesRight+i, V::select(dryRight, zero,
+						V::add(V::mul(right0, beta0), V::mul(right1, beta1))));
+					V::store(huNetUpdatesLeft+i, V::select(dryLeft, zero,
+						V::add(V::mul(left0, flux0), V::mul(left1, flux1))));
+					V::store(huNetUpdatesRight+i, V::select(dryRight, zero,
+						V::add(V::mul(right0, flux0), V::mul(right1, flux1))));
+				}
+
+				// Reduce the wave speed in registers
+				Vec edgeSpeed = V::select(dryDry, zero, V::max(V::abs(speed0), V::abs(speed1)));
+				maxWaveSpeed = V::max(maxWaveSpeed, edgeSpeed);
+				if (waveSpeeds)
+					V::store(waveSpeeds+i, edgeSpeed);
+			}
+
+			return V::reduceMax(maxWaveSpeed);
+		}
+
+		/**
+		 * @brief Computes the net-updates for complete vectors of edges
+		 */
+		template<class V, typename In> typename V::Scalar fwaveSweep(const In *h,
+			const In *hu, const In *b,
+			typename V::Scalar *hNetUpdatesLeft, typename V::Scalar *hNetUpdatesRight,
+			typename V::Scalar *huNetUpdatesLeft, typename V::Scalar *huNetUpdatesRight,
+			typename V::Scalar *waveSpeeds, unsigned int &i, unsigned int end, unsigned int stride)
+		{
+			return fwaveSweep<V, true, In>(h, hu, b,
+				hNetUpdatesLeft, hNetUpdatesRight,
+				huNetUpdatesLeft, huNetUpdatesRight,
+				waveSpeeds, i, end, stride);
+		}
+
+		/**
+		 * @brief Computes only the maximum wave speed for complete vectors of edges
+		 */
+		template<class V, typename In> typename V::Scalar maxWaveSpeedSweep(const In *h,
+			const In *hu, const In *b,
+			unsigned int &i, unsigned int end)
+		{
+			return fwaveSweep<V, false, In>(h, hu, b,
+				(typename V::Scalar*) 0L, (typename V::Scalar*) 0L,
+				(typename V::Scalar*) 0L, (typename V::Scalar*) 0L,
+				(typename V::Scalar*) 0L, i, end, 1);
+		}
+
+		/**
+		 * @brief Refines an approximation y of 1/sqrt(x) to the precision of V::Scalar
+		 *
+		 * A Newton step y (3/2 - x/2 y^2) squares the relative error e (to about 3/2 e^2),
+		 * so the number of correct bits roughly doubles. V::rsqrtBits is the precision
+		 * of the approximation, the steps stop once the mantissa is reached.
+		 */
+		template<class V> typename V::Vec refineRsqrt(typename V::Vec x, typename V::Vec y)
+		{
+			const typename V::Vec halfX = V::mul(V::set1(.5), x);
+			const typename V::Vec threeHalves = V::set1(1.5);
+			for (unsigned int bits = V::rsqrtBits; bits < (unsigned int) std::numeric_limits<typename V::Scalar>::digits; bits *= 2)
+				y = V::mul(y, V::sub(threeHalves, V::mul(halfX, V::mul(y, y))));
+			return y;
+		}
+
+		/**
+		 * @brief Computes the velocity, the celerity and the froude number of complete vectors of cells
+		 *
+		 * Dry cells (h below the zero precision of solver::FWave::computeFroude) are handled
+		 * with masks and get zero in all outputs. Without Fast, the values are computed as in
+		 * solver::FWave::computeFroude (u = hu/h, c = sqrt(g h), Fr = |u|/c) and match it exactly.
+		 * With Fast, r = 1/sqrt(g h) comes from the approximate reciprocal square root of the
+		 * instruction set and refineRsqrt, and c = g h r, u = g hu r^2, Fr = |u| r need no
+		 * division or square root.
+		 *
+		 * @param[out] u The velocities, not written if null
+		 * @param[out] celerity The celerities sqrt(g h), not written if null
+		 * @param[out] froude The froude numbers, not written if null
+		 * @param[in,out] i The first cell, set to the first cell that was not processed
+		 * @param end One past the last cell
+		 *
+		 * @return The maximum characteristic speed |u| + c of the processed cells
+		 */
+		template<class V, bool Fast, typename In> typename V::Scalar cellSweep(const In *h, const In *hu,
+			typename V::Scalar *u, typename V::Scalar *celerity, typename V::Scalar *froude,
+			unsigned int &i, unsigned int end)
+		{
+			typedef typename V::Scalar S;
+			typedef typename V::Vec Vec;
+			typedef typename V::Mask Mask;
+
+			// The solver compares the water height with the dry height in double
+			const Vec gravity = V::set1((S) FWaveConstants::GRAVITY);
+			S dryLimit = (S) FWaveConstants::FROUDE_DRY_HEIGHT;
+			if ((double) dryLimit < FWaveConstants::FROUDE_DRY_HEIGHT)
+				dryLimit = std::nextafter(dryLimit, (S) 1);
+			const Vec zeroPrecision = V::set1(dryLimit);
+
+			const Vec zero = V::set1(0);
+			const Vec one = V::set1(1);
+
+			Vec maxSpeed = zero;
+
+			for (; i + V::width <= end; i += V::width)
+			{
+				Vec hCell = V::load(h+i);
+				Vec huCell = V::load(hu+i);
+
+				// Dry lanes compute with h = 1 and are set to zero afterwards
+				Mask dry = V::lt(hCell, zeroPrecision);
+				hCell = V::select(dry, one, hCell);
+				Vec gh = V::mul(gravity, hCell);
+
+				Vec velocity, c, fr;
+				if (Fast)
+				{
+					Vec r = refineRsqrt<V>(gh, V::rsqrt(gh));
+					c = V::mul(gh, r);
+					velocity = V::mul(V::mul(gravity, huCell), V::mul(r, r));
+					fr = V::mul(V::abs(velocity), r);
+				}
+				else
+				{
+					velocity = V::div(huCell, hCell);
+					c = V::sqrt(gh);
+					fr = V::div(V::abs(velocity), c);
+				}
+
+				velocity = V::select(dry, zero, velocity);
+				c = V::select(dry, zero, c);
+				fr = V::select(dry, zero, fr);
+
+				if (u)
+					V::store(u+i, velocity);
+				if (celerity)
+					V::store(celerity+i, c);
+				if (froude)
+					V::store(froude+i, fr);
+				maxSpeed = V::max(maxSpeed, V::add(V::abs(velocity), c));
+			}
+
+			return V::reduceMax(maxSpeed);
+		}
+
+	}
+
+}
+
+#endif /* KERNELS_FWAVEBATCHIMPL_H_ */
@@ -0,0 +1,38 @@
+/**
+ * @file FWaveConstants.hpp
+ * @brief Constants of the f-wave solver
+ */
+
+#ifndef KERNELS_FWAVECONSTANTS_H_
+#define KERNELS_FWAVECONSTANTS_H_
+
+namespace kernels
+{
+
+	/**
+	 * @brief The constants of the default solver::FWave
+	 *
+	 * The batched kernels (f-wave and cell quantities) and the refinement indicator of
+	 * AmrWavePropagation reimplement parts of the solver. They take the constants from
+	 * here, so they stay in sync with each other. The values are the default arguments
+	 * of the solver::FWave constructor and its ZERO_PRECISION. They are converted to the
+	 * precision of the computation where they are used.
+	 */
+	struct FWaveConstants
+	{
+		/** @brief The gravity */
+		static constexpr double GRAVITY = 9.81;
+
+		/** @brief Cells with a smaller water height are dry */
+		static constexpr double DRY_TOLERANCE = 0.01;
+
+		/** @brief Wave speeds within this tolerance of zero do not move */
+		static constexpr double ZERO_TOLERANCE = 0.000000001;
+
+		/** @brief Cells with a smaller water height have froude number zero (ZERO_PRECISION of the solver) */
+		static constexpr double FROUDE_DRY_HEIGHT = 0.000001;
+	};
+
+}
+
+#endif /* KERNELS_FWAVECONSTANTS_H_ */
@@ -3,96 +3,866 @@
  * @brief Framwork entry point
  */
 
+#include <chrono>
 #include <cstring>
-#include "types.hpp"
+#include <sstream>
+#include <type_traits>
+#include <vector>
 #include "WavePropagation.hpp"
+#include "EnsembleWavePropagation.hpp"
+#include "AmrWavePropagation.hpp"
+#include "LtsWavePropagation.hpp"
 #include "writer/VtkWriter.hpp"
+#include "writer/SeriesWriter.hpp"
+#include "writer/AsyncWriter.hpp"
+#include "writer/CheckpointWriter.hpp"
+#include "writer/ParallelVtkWriter.hpp"
+#include "writer/ConsoleWriter.hpp"
+#include "reader/CheckpointReader.hpp"
 #include "tools/args.hpp"
+#include "tools/arena.hpp"
+#include "tools/profiler.hpp"
+#include "tools/counters.hpp"
+#include "tools/scheduler.hpp"
+#include "tools/mpi.hpp"
 
-#include "scenarios/hydraulicsup.hpp"
-#include "scenarios/hydraulicsub.hpp"
-#include "scenarios/dambreak.hpp"
-#include "scenarios/shockshock.hpp"
-#include "scenarios/rarerare.hpp"
-#include "scenarios/bathtub.hpp"
-// #include "writer/ConsoleWriter.h"
+#include "scenarios/registry.hpp"
+#include "scenarios/profile.hpp"
+#include "scenarios/fill.hpp"
 
 /**
- * @brief OS entry point
- * 
- * @param argc Argument count
- * @param argv Argument buffer
- * 
- * @return The error code
+ * @brief Measures the limits of the machine for the roofline model
+ *
+ * The peak bandwidth is measured with a triad. The compute limit is the FLOP/s of the
+ * batched f-wave kernel on a domain that fits into the L1 cache, which is the best this
+ * kernel can achieve (0 if the floating point events are not available).
+ *
+ * @param counters The hardware counters
+ * @param threads Number of threads
  */
-int main(int argc, char** argv)
+template<typename T, typename C> tools::Roofline measureRoofline(const tools::PerfCounters &counters,
+	unsigned int threads)
 {
-	// Parse command line parameters
-	tools::Args args(argc, argv);
+	tools::Roofline roofline;
+	roofline.bandwidth = tools::measureBandwidth(threads);
+
+	// A dam break on 1024 cells
+	const unsigned int size = 1024;
+	const unsigned int repetitions = 2000;
+	tools::PerfCounters::Values start, end;
+
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	counters.read(start);
+	#pragma omp parallel num_threads(threads)
+	{
+		std::vector<T> h(size+2, 20), hu(size+2, 0), b(size+2, -10);
+		std::fill(h.begin() + size/2, h.end(), 5);
+		std::vector<C> netUpdates(4*(size+1));
+		kernels::FWaveBatch<T, C> fwave;
+
+		for (unsigned int i = 0; i < repetitions; i++)
+			fwave.computeNetUpdates(&h[0], &hu[0], &b[0],
+				&netUpdates[0], &netUpdates[size+1], &netUpdates[2*(size+1)], &netUpdates[3*(size+1)],
+				0, size+1);
+	}
+	counters.read(end);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	for (unsigned int e = 0; e < tools::PerfCounters::EVENTS; e++)
+		end.count[e] -= start.count[e];
+	roofline.flops = tools::PerfCounters::flops(end, sizeof(C)) / seconds;
+
+	return roofline;
+}
+
+/**
+ * @brief Runs the time loop
+ *
+ * @param args The command line parameters
+ * @param wavePropagation The solver working on h, hu and b
+ * @param output The writer used for the output
+ * @param h Water height
+ * @param hu Momentum
+ * @param b Bathymetry
+ * @param checkpoints The writer used for the checkpoints
+ * @param firstStep The first time step (non-zero after a restart)
+ * @param startTime The simulated time of the first time step
+ * @param outputs Number of outputs written before the first time step
+ */
+template<typename T, typename C, class Writer> void simulate(tools::Args &args,
+	WavePropagation<T, C> &wavePropagation, Writer &output,
+	T *h, T *hu, T *b, writer::CheckpointWriter<T> &checkpoints,
+	unsigned int firstStep = 0, C startTime = 0, unsigned long long outputs = 0)
+{
+	// Write in the background, so the next time step can be computed in the meantime
+	writer::AsyncWriter<T, Writer> writer(output, args.asyncBuffers());
+
+	// Decides which time steps are written
+	tools::OutputScheduler scheduler(args.outputSteps(), args.outputInterval());
+
+	// Current time of simulation
+	C t = startTime;
+	if (firstStep > 0)
+		scheduler.resume(t);
+	else if (scheduler.due(0, t))
+	{
+		writer.write(t, h, hu, b, args.size());
+		outputs++;
+	}
+
+	// Wall-clock time of the last checkpoint
+	std::chrono::steady_clock::time_point lastCheckpoint = std::chrono::steady_clock::now();
+
+	// Number of computed blocks (active blocks only)
+	unsigned long long blockUpdates = 0;
+
+	// Hardware counters of the flux computation and the update
+	tools::PerfCounters *counters = 0L;
+	tools::PhaseCounters *fluxCounters = 0L, *updateCounters = 0L;
+	if (args.counters())
+	{
+		counters = new tools::PerfCounters(args.threads());
+		if (!counters->available())
+			tools::Logger::logger.warning("Hardware counters are not available (see /proc/sys/kernel/perf_event_paranoid)");
+		fluxCounters = new tools::PhaseCounters("computeNumericalFluxes", *counters, sizeof(C));
+		updateCounters = new tools::PhaseCounters("updateUnknowns", *counters, sizeof(C));
+	}
 
-	// Scenario
-	scenarios::Bathtub scenario(args.size()); //, args.options());
+	for (unsigned int i = firstStep; i < args.timeSteps(); i++) 
+	{
+		// Do one time step
+		{
+			PROFILE_SCOPE(LOGGING, 0);
+			LOG_EVERY(args.progressInterval(), "Computing timestep " << i << " at time " << t);
+		}
+		C maxTimeStep;
+		if (args.fused())
+		{
+			// Boundaries, fluxes and unknowns in a single sweep
+			PROFILE_SCOPE(FUSED, args.size());
+			maxTimeStep = wavePropagation.computeFusedTimeStep();
+		}
+		else
+		{
+			// Update boundaries
+			{
+				PROFILE_SCOPE(BOUNDARY, 0);
+				wavePropagation.setOutflowBoundaryConditions();
+			}
+			// Compute numerical flux on each edge
+			{
+				PROFILE_SCOPE(FLUXES, args.size()+1);
+				if (fluxCounters)
+					fluxCounters->start();
+				maxTimeStep = wavePropagation.computeNumericalFluxes();
+				if (fluxCounters)
+					fluxCounters->stop(args.size()+1);
+			}
+			blockUpdates += wavePropagation.activeBlocks();
+			// Update unknowns from net updates
+			{
+				PROFILE_SCOPE(UPDATE, args.size());
+				if (updateCounters)
+					updateCounters->start();
+				wavePropagation.updateUnknowns(maxTimeStep);
+				if (updateCounters)
+					updateCounters->stop(args.size());
+			}
+		}
+		LOG_DEBUG("Time step" << tools::kv("step", i) << tools::kv("dt", maxTimeStep));
+		// Update time
+		t += maxTimeStep;
+		// Write new values (always write the last time step)
+		if (scheduler.due(i+1, t) || i+1 == args.timeSteps())
+		{
+			PROFILE_SCOPE(OUTPUT, args.size());
+			writer.write(t, h, hu, b, args.size());
+			outputs++;
+		}
 
+		// Save a checkpoint after a number of time steps or wall-clock seconds
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if ((args.checkpointSteps() > 0 && (i+1) % args.checkpointSteps() == 0)
+				|| (args.checkpointInterval() > 0
+					&& std::chrono::duration<double>(now - lastCheckpoint).count() >= args.checkpointInterval()))
+		{
+			PROFILE_SCOPE(CHECKPOINT, args.size());
+			tools::Logger::logger << "Saving checkpoint after timestep " << i+1 << std::endl;
+			checkpoints.write(t, i+1, outputs, h, hu, b, args.size());
+			lastCheckpoint = now;
+		}
+	}
+
+	if (wavePropagation.blocks() > 0)
+		tools::Logger::logger << "Computed " << blockUpdates << " of "
+			<< (unsigned long long) wavePropagation.blocks() * (args.timeSteps() - firstStep) << " blocks" << std::endl;
+
+	if (counters)
+	{
+		if (args.fused())
+			tools::Logger::logger.warning("Hardware counters are only read in the separate passes");
+		else
+		{
+			tools::Roofline roofline = measureRoofline<T, C>(*counters, args.threads());
+			fluxCounters->report(tools::Logger::logger.info(), roofline);
+			updateCounters->report(tools::Logger::logger.info(), roofline);
+		}
+		delete fluxCounters;
+		delete updateCounters;
+		delete counters;
+	}
+
+#ifdef PROFILE
+	// Time spent in the phases of the time loop (the last output may still be written in the background)
+	tools::Profiler::profiler.report(tools::Logger::logger.info());
+	if (!args.profileJson().empty())
+		tools::Profiler::profiler.writeJson(args.profileJson());
+#else
+	if (!args.profileJson().empty())
+		tools::Logger::logger.warning("Profiling is disabled, build with profile=1");
+#endif
+}
+
+/**
+ * @brief Loads the unknowns from a checkpoint
+ *
+ * The checkpoint has to match the scenario, the domain size and the storage precision.
+ * It does not depend on the number of threads.
+ *
+ * @param args The command line parameters
+ * @param scenario The name of the scenario
+ * @param h Water height
+ * @param hu Momentum
+ * @param b Bathymetry
+ * @param[out] step The number of time steps done
+ * @param[out] time The simulated time
+ * @param[out] outputs The number of outputs written
+ */
+template<typename T, typename C> void restart(tools::Args &args, const std::string &scenario,
+	T *h, T *hu, T *b, unsigned int &step, C &time, unsigned long long &outputs)
+{
+	reader::CheckpointReader checkpoint(args.restart());
+	if (!checkpoint.good())
+		tools::Logger::logger.error(checkpoint.error().c_str());
+	if (checkpoint.scenario() != scenario || checkpoint.header().cells != args.size())
+		tools::Logger::logger.error("The checkpoint was written for a different scenario or domain size");
+	if (!checkpoint.template field<T>(0))
+		tools::Logger::logger.error("The checkpoint was written with a different precision");
+
+	T *fields[writer::CHECKPOINT_FIELDS] = {h, hu, b};
+	for (unsigned int i = 0; i < writer::CHECKPOINT_FIELDS; i++)
+		std::memcpy(fields[i], checkpoint.template field<T>(i), (args.size()+2)*sizeof(T));
+
+	step = checkpoint.header().step;
+	time = checkpoint.header().time;
+	outputs = checkpoint.header().outputs;
+
+	tools::Logger::logger << "Restarting after timestep " << step << " at time " << time << std::endl;
+}
+
+/**
+ * @brief Creates the writer selected on the command line and passes it to a time loop
+ *
+ * @param args The command line parameters
+ * @param cellSize The size of a cell
+ * @param outputs Number of outputs written before a restart, kept by the writer
+ * @param loop Runs the time loop, called with the writer
+ */
+template<typename T, class Loop> void withWriter(tools::Args &args, T cellSize, unsigned long long outputs, Loop loop)
+{
+	if (args.output() == tools::Args::SERIES)
+	{
+		// After a restart, the file keeps the time steps written before the checkpoint
+		writer::SeriesWriter<T> seriesWriter("swe1d", cellSize, outputs);
+		seriesWriter.setFastFroude(args.fastFroude());
+		loop(seriesWriter);
+	}
+	else if (args.output() == tools::Args::CSV || args.output() == tools::Args::TSV)
+	{
+		writer::ConsoleWriter<T> consoleWriter(cellSize,
+			args.output() == tools::Args::TSV ? writer::ConsoleWriter<T>::TSV : writer::ConsoleWriter<T>::CSV,
+			args.digits(), args.threads());
+		consoleWriter.setRegions(args.regions());
+		consoleWriter.setFastFroude(args.fastFroude());
+		loop(consoleWriter);
+	}
+	else
+	{
+		// After a restart, continue the numbering of the files and the collection
+		writer::VtkWriter<T> vtkWriter("swe1d", cellSize,
+			args.binary() ? writer::VtkWriter<T>::BINARY : writer::VtkWriter<T>::ASCII, outputs);
+		vtkWriter.setRegions(args.regions());
+		vtkWriter.setFastFroude(args.fastFroude());
+		vtkWriter.setCompression(args.compression(), args.compressionBlock(), args.compressionLevel(), args.threads());
+		loop(vtkWriter);
+	}
+}
+
+/**
+ * @brief Runs the simulation of a scenario with one precision
+ *
+ * @param args The command line parameters
+ * @param scenario The scenario
+ * @param scenarioName The name of the scenario, stored in the checkpoints
+ *
+ * @return The error code
+ */
+template<typename T, typename C, class Scenario> int run(tools::Args &args, Scenario &scenario,
+	const std::string &scenarioName)
+{
 	// Allocate memory
+	tools::State<T> state(args.size(), 1, args.hugePages());
 	// Water height
-	T *h = new T[args.size()+2];
+	T *h = state.h();
 	// Momentum
-	T *hu = new T[args.size()+2];
+	T *hu = state.hu();
 	//Bathymetry 0 is sealevel
-	T *b = new T[args.size()+2];
-	//Frode numbers
-	T *f = new T[args.size()+2];
+	T *b = state.b();
 
 	// Initialize water height and momentum
-	for (unsigned int i = 0; i < args.size()+2; i++)
-	{
-		b[i] = scenario.getBathy(i);
-		h[i] = scenario.getHeight(i) - b[i]; //substract bathymetry, b/c water height is given as surface level, not water volume
-		if (h[i] < ZERO_PRECISION) {
-			h[i] = 0;
-		}
-		hu[i] = scenario.getSpeed(i);
-		f[i] = 0;
-	}
+	scenarios::initialize(scenario, args.size(), h, hu, b, args.threads());
 
-	// Create a writer that is responsible printing out values
-	//writer::ConsoleWriter writer;
-	writer::VtkWriter writer("swe1d", scenario.getCellSize());
+	// Continue a previous simulation instead
+	unsigned int firstStep = 0;
+	C startTime = 0;
+	unsigned long long outputs = 0;
+	if (!args.restart().empty())
+		restart(args, scenarioName, h, hu, b, firstStep, startTime, outputs);
 
 	// Helper class computing the wave propagation
-	WavePropagation wavePropagation(args.size(), scenario.getCellSize(), h, hu, b, f);
-	//Calculate initial froude numbers
-	wavePropagation.computeFroude();
+	WavePropagation<T, C> wavePropagation(args.size(), scenario.getCellSize(), h, hu, b, args.fused(), args.threads(),
+		args.hugePages());
+	tools::Logger::logger << "Using the " << kernels::isaName(wavePropagation.isa()) << " f-wave kernel" << std::endl;
+	if (args.activeBlocks())
+	{
+		if (args.fused())
+			tools::Logger::logger.error("Active blocks are not available in fused mode");
+		wavePropagation.setActiveBlocks(args.blockSize(), args.sleepThreshold());
+	}
 	// Write initial data
 	tools::Logger::logger.info("Initial data");
 
+	// Saves the checkpoints
+	writer::CheckpointWriter<T> checkpoints("swe1d.checkpoint", scenarioName, scenario.getCellSize(),
+		args.checkpointAsync());
+
+	withWriter<T>(args, scenario.getCellSize(), outputs, [&](auto &output) {
+		simulate(args, wavePropagation, output, h, hu, b, checkpoints, firstStep, startTime, outputs);
+	});
+
+	return 0;
+}
+
+/**
+ * @brief Runs the time loop of an ensemble, every member is written separately
+ *
+ * @param args The command line parameters
+ * @param ensemble The solver working on all members
+ * @param outputs One writer per member
+ */
+template<typename T, typename C, class Writer> void simulateEnsemble(tools::Args &args,
+	EnsembleWavePropagation<T, C> &ensemble, std::vector<Writer*> &outputs)
+{
+	const unsigned int members = ensemble.members();
+
+	std::vector<writer::AsyncWriter<T, Writer>*> writers(members);
+	std::vector<tools::OutputScheduler> schedulers(members,
+		tools::OutputScheduler(args.outputSteps(), args.outputInterval()));
+	for (unsigned int k = 0; k < members; k++)
+		writers[k] = new writer::AsyncWriter<T, Writer>(*outputs[k], args.asyncBuffers());
+
+	// Values of a single member
+	std::vector<T> member(3*(args.size()+2));
+	T *h = &member[0];
+	T *hu = h + args.size()+2;
+	T *b = hu + args.size()+2;
+
+	// Current time of simulation of every member
+	std::vector<C> t(members, 0);
+	for (unsigned int k = 0; k < members; k++)
+	{
+		if (schedulers[k].due(0, t[k]))
+		{
+			ensemble.getMember(k, h, hu, b);
+			writers[k]->write(t[k], h, hu, b, args.size());
+		}
+	}
+
+	for (unsigned int i = 0; i < args.timeSteps(); i++)
+	{
+		// Do one time step for all members
+		LOG_EVERY(args.progressInterval(), "Computing timestep " << i << " at time " << t[0]);
+		ensemble.setOutflowBoundaryConditions();
+		ensemble.computeNumericalFluxes();
+		ensemble.updateUnknowns();
+
+		for (unsigned int k = 0; k < members; k++)
+		{
+			// Update time and write new values (always write the last time step)
+			t[k] += ensemble.timeStep(k);
+			if (schedulers[k].due(i+1, t[k]) || i+1 == args.timeSteps())
+			{
+				ensemble.getMember(k, h, hu, b);
+				writers[k]->write(t[k], h, hu, b, args.size());
+			}
+		}
+	}
+
+	for (unsigned int k = 0; k < members; k++)
+		delete writers[k];
+}
+
+/**
+ * @brief The base name of the output files of an ensemble member
+ *
+ * @param member The member
+ */
+std::string memberName(unsigned int member)
+{
+	std::ostringstream name;
+	name << "swe1d_member" << member;
+	return name.str();
+}
+
+/**
+ * @brief Initializes one member of an ensemble from a scenario
+ */
+template<typename T> struct MemberInitializer
+{
+	/** @brief Number of cells */
+	unsigned int size;
+	/** @brief Number of members */
+	unsigned int members;
+	/** @brief The member */
+	unsigned int member;
+	/** @brief Number of threads */
+	unsigned int threads;
+	/** @brief The interleaved water heights, momentums and bathymetries */
+	T *h, *hu, *b;
+	/** @brief The cell size of the scenario */
+	T cellSize;
+
+	/**
+	 * @brief Fills the member with the values of the scenario
+	 */
+	template<class Scenario> int operator()(Scenario &scenario)
+	{
+		std::vector<T> values(3*(size+2));
+		T *memberH = &values[0];
+		T *memberHu = memberH + size+2;
+		T *memberB = memberHu + size+2;
+		scenarios::initialize(scenario, size, memberH, memberHu, memberB, threads);
+
+		for (unsigned int i = 0; i < size+2; i++)
+		{
+			unsigned int j = i*members + member;
+			h[j] = memberH[i];
+			hu[j] = memberHu[i];
+			b[j] = memberB[i];
+		}
+
+		cellSize = scenario.getCellSize();
+		return 0;
+	}
+};
+
+/**
+ * @brief Sets up the ensemble and runs the simulation with one precision
+ *
+ * Member k uses the selected scenario with the first parameter interpolated
+ * linearly between the bounds of the sweep (or the given parameters without a sweep).
+ *
+ * @param args The command line parameters
+ *
+ * @return The error code
+ */
+template<typename T, typename C> int runEnsemble(tools::Args &args)
+{
+	const unsigned int members = args.members();
+	const unsigned int size = args.size();
+
+	if (args.fused())
+		tools::Logger::logger.warning("Ensembles do not support fused time steps, using separate passes");
+
+	// Allocate memory, the values of all members for one cell are stored next to each other
+	tools::State<T> state(size, members, args.hugePages());
+	T *h = state.h();
+	T *hu = state.hu();
+	T *b = state.b();
+
+	const scenarios::Type type = args.scenario();
+	if (args.hasSweep() && scenarios::describe(type).parameterCount == 0)
+		tools::Logger::logger.error("The scenario has no parameter that can be swept");
+
+	// Initialize every member with its own scenario
+	MemberInitializer<T> initializer = {size, members, 0, args.threads(), h, hu, b, 0};
+	for (unsigned int k = 0; k < members; k++)
+	{
+		std::vector<double> parameters = args.scenarioParameters();
+		if (args.hasSweep())
+		{
+			double fraction = members > 1 ? (double) k / (members-1) : 0;
+			parameters.resize(std::max<size_t>(parameters.size(), 1));
+			parameters[0] = args.sweep().first + fraction * (args.sweep().second - args.sweep().first);
+		}
+		tools::Logger &log = tools::Logger::logger << "Member " << k << ": " << scenarios::describe(type).name;
+		for (unsigned int i = 0; i < scenarios::describe(type).parameterCount; i++)
+			log << ':' << scenarios::parameter(type, parameters, i);
+		log << std::endl;
+
+		initializer.member = k;
+		scenarios::dispatch<T>(type, parameters, size, initializer);
+	}
+
+	const T cellSize = initializer.cellSize;
+	EnsembleWavePropagation<T, C> ensemble(size, members, cellSize, h, hu, b,
+		args.memberTimeSteps(), args.threads(), args.hugePages());
+	tools::Logger::logger << "Using the " << kernels::isaName(ensemble.isa()) << " f-wave kernel for "
+		<< members << " members" << std::endl;
+
+	if (args.output() == tools::Args::CSV || args.output() == tools::Args::TSV)
+		tools::Logger::logger.warning("Ensembles are written as vtk files");
+	if (args.output() == tools::Args::SERIES)
+	{
+		std::vector<writer::SeriesWriter<T>*> writers(members);
+		for (unsigned int k = 0; k < members; k++)
+		{
+			writers[k] = new writer::SeriesWriter<T>(memberName(k), cellSize);
+			writers[k]->setFastFroude(args.fastFroude());
+		}
+		simulateEnsemble(args, ensemble, writers);
+		for (unsigned int k = 0; k < members; k++)
+			delete writers[k];
+	}
+	else
+	{
+		std::vector<writer::VtkWriter<T>*> writers(members);
+		for (unsigned int k = 0; k < members; k++)
+		{
+			writers[k] = new writer::VtkWriter<T>(memberName(k), cellSize,
+				args.binary() ? writer::VtkWriter<T>::BINARY : writer::VtkWriter<T>::ASCII);
+			writers[k]->setRegions(args.regions());
+			writers[k]->setFastFroude(args.fastFroude());
+			writers[k]->setCompression(args.compression(), args.compressionBlock(), args.compressionLevel(),
+				args.threads());
+		}
+		simulateEnsemble(args, ensemble, writers);
+		for (unsigned int k = 0; k < members; k++)
+			delete writers[k];
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Sets up the adaptive grid and runs the simulation with one precision
+ *
+ * The domain is extended to a multiple of the block size.
+ *
+ * @param args The command line parameters
+ * @param scenario The scenario, created for the extended domain
+ *
+ * @return The error code
+ */
+template<typename T, typename C, class Scenario> int runAmr(tools::Args &args, Scenario &scenario)
+{
+	const unsigned int blockSize = args.blockSize();
+	const unsigned int blocks = (args.size() + blockSize-1) / blockSize;
+
+	if (args.fused())
+		tools::Logger::logger.warning("Adaptive grids do not support fused time steps, using separate passes");
+	if (args.output() != tools::Args::VTK)
+		tools::Logger::logger.warning("Adaptive grids are written as vtk files");
+	if (args.size() % blockSize != 0)
+		tools::Logger::logger.warning() << "The adaptive grid covers whole blocks, the domain grows"
+			<< tools::kv("cells", args.size()) << tools::kv("to", blocks*blockSize) << std::endl;
+
+	AmrWavePropagation<T, C> amr(blocks, blockSize, scenario.getCellSize(),
+		args.amrLevels(), args.amrThreshold(), args.threads());
+	amr.initialize(scenario);
+	tools::Logger::logger << "Using the " << kernels::isaName(amr.isa()) << " f-wave kernel on "
+		<< blocks << " blocks with up to " << args.amrLevels() << " refinement levels" << std::endl;
+
+	writer::VtkWriter<T> vtkWriter("swe1d", scenario.getCellSize(),
+		args.binary() ? writer::VtkWriter<T>::BINARY : writer::VtkWriter<T>::ASCII);
+	vtkWriter.setRegions(args.regions());
+	vtkWriter.setFastFroude(args.fastFroude());
+	vtkWriter.setCompression(args.compression(), args.compressionBlock(), args.compressionLevel(), args.threads());
+	writer::AsyncWriter<T, writer::VtkWriter<T> > writer(vtkWriter, args.asyncBuffers());
+
+	tools::OutputScheduler scheduler(args.outputSteps(), args.outputInterval());
+
 	// Current time of simulation
-	T t = 0;
-	writer.write(t, h, hu, b, f, args.size());
+	C t = 0;
+	if (scheduler.due(0, t))
+		writer.write(t, amr.h(), amr.hu(), amr.b(), amr.size(), amr.x());
 
-	for (unsigned int i = 0; i < args.timeSteps(); i++) 
+	for (unsigned int i = 0; i < args.timeSteps(); i++)
 	{
 		// Do one time step
-		tools::Logger::logger << "Computing timestep " << i << " at time " << t << std::endl;
-		// Update boundaries
-		wavePropagation.setOutflowBoundaryConditions();
-		// Compute numerical flux on each edge (and frode numbers)
-		T maxTimeStep = wavePropagation.computeNumericalFluxes();
-		// Update unknowns from net updates
-		wavePropagation.updateUnknowns(maxTimeStep);
-		//Update froude numbers
-		wavePropagation.computeFroude();
+		LOG_EVERY(args.progressInterval(), "Computing timestep " << i << " at time " << t
+			<< " on " << amr.size() << " cells");
+		amr.setOutflowBoundaryConditions();
+		C maxTimeStep = amr.computeNumericalFluxes();
+		amr.updateUnknowns(maxTimeStep);
+		// Adapt the grid to the new unknowns
+		amr.regrid();
 		// Update time
 		t += maxTimeStep;
-		// Write new values
-		writer.write(t, h, hu, b, f, args.size());
+		// Write new values (always write the last time step)
+		if (scheduler.due(i+1, t) || i+1 == args.timeSteps())
+			writer.write(t, amr.h(), amr.hu(), amr.b(), amr.size(), amr.x());
 	}
 
-	// Free allocated memory
-	delete [] h;
-	delete [] hu;
-	delete [] b;
-	delete [] f;
+	return 0;
+}
+
+/**
+ * @brief Runs the simulation of a scenario with local time stepping
+ *
+ * @param args The command line parameters
+ * @param scenario The scenario
+ *
+ * @return The error code
+ */
+template<typename T, typename C, class Scenario> int runLts(tools::Args &args, Scenario &scenario)
+{
+	const unsigned int size = args.size();
+
+	if (args.fused())
+		tools::Logger::logger.warning("Local time stepping does not support fused time steps, using separate passes");
+
+	// Allocate memory
+	tools::State<T> state(size, 1, args.hugePages());
+	T *h = state.h();
+	T *hu = state.hu();
+	T *b = state.b();
+
+	// Initialize water height and momentum
+	scenarios::initialize(scenario, size, h, hu, b, args.threads());
+
+	LtsWavePropagation<T, C> lts(size, scenario.getCellSize(), h, hu, b,
+		args.blockSize(), args.ltsLevels(), args.threads());
+	tools::Logger::logger << "Using the " << kernels::isaName(lts.isa()) << " f-wave kernel with up to "
+		<< args.ltsLevels() << " time step levels" << std::endl;
+
+	withWriter<T>(args, scenario.getCellSize(), 0, [&](auto &output) {
+		writer::AsyncWriter<T, typename std::remove_reference<decltype(output)>::type> writer(output,
+			args.asyncBuffers());
+
+		tools::OutputScheduler scheduler(args.outputSteps(), args.outputInterval());
+
+		// Current time of simulation
+		C t = 0;
+		if (scheduler.due(0, t))
+			writer.write(t, h, hu, b, size);
+
+		for (unsigned int i = 0; i < args.timeSteps(); i++)
+		{
+			// Do one macro time step (up to 2^levels global time steps)
+			LOG_EVERY(args.progressInterval(), "Computing macro timestep " << i << " at time " << t);
+			t += lts.computeLocalTimeStep();
+			// Write new values (always write the last time step)
+			if (scheduler.due(i+1, t) || i+1 == args.timeSteps())
+				writer.write(t, h, hu, b, size);
+		}
+	});
+
+	tools::Logger::logger << "Cell updates: " << lts.cellUpdates() << " (global time steps: "
+		<< lts.globalCellUpdates() << ")" << std::endl;
 
 	return 0;
 }
+
+/**
+ * @brief Runs the simulation of a scenario distributed over several processes
+ *
+ * Every process computes one slab of the domain. The ghost cells are exchanged
+ * while the edges inside the slab are computed, and all processes use the
+ * smallest time step. The result does not depend on the number of processes.
+ *
+ * @param args The command line parameters
+ * @param scenario The scenario, created for the whole domain
+ *
+ * @return The error code
+ */
+template<typename T, typename C, class Scenario> int runDistributed(tools::Args &args, Scenario &scenario)
+{
+	tools::Decomposition decomposition(args.size());
+	const unsigned int size = decomposition.size();
+
+	if (args.output() != tools::Args::VTK)
+		tools::Logger::logger.warning("Distributed domains are written as vtk files");
+	if (!args.regions().empty())
+		tools::Logger::logger.warning("Distributed domains do not support output regions");
+
+	// Allocate memory for the slab of this process
+	tools::State<T> state(size, 1, args.hugePages());
+	T *h = state.h();
+	T *hu = state.hu();
+	T *b = state.b();
+
+	// Initialize the slab with the cells of the whole domain
+	scenarios::initialize(scenario, size, h, hu, b, args.threads(), decomposition.offset());
+
+	WavePropagation<T, C> wavePropagation(size, scenario.getCellSize(), h, hu, b, false, args.threads(),
+		args.hugePages());
+	tools::Logger::logger << "Using the " << kernels::isaName(wavePropagation.isa()) << " f-wave kernel on "
+		<< decomposition.ranks() << " processes" << std::endl;
+
+	writer::ParallelVtkWriter<T> vtkWriter("swe1d", scenario.getCellSize(),
+		args.binary() ? writer::VtkWriter<T>::BINARY : writer::VtkWriter<T>::ASCII,
+		decomposition.rank(), decomposition.bounds());
+	vtkWriter.setFastFroude(args.fastFroude());
+	vtkWriter.setCompression(args.compression(), args.compressionBlock(), args.compressionLevel(), args.threads());
+	writer::AsyncWriter<T, writer::ParallelVtkWriter<T> > writer(vtkWriter, args.asyncBuffers());
+
+	tools::OutputScheduler scheduler(args.outputSteps(), args.outputInterval());
+
+	// Current time of simulation
+	C t = 0;
+	if (scheduler.due(0, t))
+		writer.write(t, h, hu, b, size);
+
+	for (unsigned int i = 0; i < args.timeSteps(); i++)
+	{
+		// Do one time step
+		LOG_EVERY(args.progressInterval(), "Computing timestep " << i << " at time " << t);
+
+		// Compute the edges inside the slab while the ghost cells are exchanged
+		decomposition.startExchange(h, hu);
+		C maxWaveSpeed = wavePropagation.computeNumericalFluxes(1, size);
+		decomposition.finishExchange(h, hu);
+		maxWaveSpeed = std::max(maxWaveSpeed, wavePropagation.computeNumericalFluxes(0, 1));
+		maxWaveSpeed = std::max(maxWaveSpeed, wavePropagation.computeNumericalFluxes(size, size+1));
+
+		C maxTimeStep = decomposition.minTimeStep(wavePropagation.maxTimeStep(maxWaveSpeed));
+		wavePropagation.updateUnknowns(maxTimeStep);
+		// Update time
+		t += maxTimeStep;
+		// Write new values (always write the last time step)
+		if (scheduler.due(i+1, t) || i+1 == args.timeSteps())
+			writer.write(t, h, hu, b, size);
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Runs the simulation of the scenario selected at runtime
+ *
+ * Every scenario gets its own instantiation of the drivers, so the calls
+ * of the scenario are resolved at compile time.
+ */
+template<typename T, typename C> struct Driver
+{
+	/** @brief The command line parameters */
+	tools::Args &args;
+	/** @brief The name of the scenario, stored in the checkpoints */
+	const char *name;
+
+	/**
+	 * @brief Runs the simulation with the driver selected by the command line parameters
+	 */
+	template<class Scenario> int operator()(Scenario &scenario)
+	{
+		if (args.amrLevels() > 0)
+			return runAmr<T, C>(args, scenario);
+		if (args.ltsLevels() > 0)
+			return runLts<T, C>(args, scenario);
+		if (tools::Mpi::ranks() > 1)
+			return runDistributed<T, C>(args, scenario);
+		return run<T, C>(args, scenario, name);
+	}
+};
+
+/**
+ * @brief Sets up the scenario and runs the simulation with one precision
+ *
+ * @param args The command line parameters
+ *
+ * @return The error code
+ */
+template<typename T, typename C> int run(tools::Args &args)
+{
+	if (args.members() > 0)
+		return runEnsemble<T, C>(args);
+
+	// Adaptive grids extend the domain to a multiple of the block size
+	unsigned int size = args.size();
+	if (args.amrLevels() > 0)
+		size = (size + args.blockSize()-1) / args.blockSize() * args.blockSize();
+
+	if (!args.bathymetry().empty())
+	{
+		scenarios::Profile<T> scenario(size, args.bathymetry(), args.length());
+		if (!scenario.good())
+			tools::Logger::logger.error(scenario.error().c_str());
+		tools::Logger::logger << "Resampling " << scenario.samples() << " samples of "
+			<< args.bathymetry() << " onto " << size << " cells" << std::endl;
+		Driver<T, C> driver = {args, "profile"};
+		return driver(scenario);
+	}
+
+	tools::Logger::logger << "Scenario " << scenarios::describe(args.scenario()).name << std::endl;
+	Driver<T, C> driver = {args, scenarios::describe(args.scenario()).name};
+	return scenarios::dispatch<T>(args.scenario(), args.scenarioParameters(), size, driver);
+}
+
+/**
+ * @brief OS entry point
+ * 
+ * @param argc Argument count
+ * @param argv Argument buffer
+ * 
+ * @return The error code
+ */
+int main(int argc, char** argv)
+{
+	// Start the processes of a distributed run
+	tools::Mpi mpi(argc, argv);
+
+	// Only the first process reports the progress
+	if (tools::Mpi::rank() > 0)
+		tools::Logger::logger.setLevel(tools::Logger::ERROR);
+
+	// Parse command line parameters
+	tools::Args args(argc, argv);
+	if (tools::Mpi::rank() == 0)
+		tools::Logger::logger.setLevel(args.logLevel());
+
+	if ((args.members() > 0 || args.amrLevels() > 0 || args.ltsLevels() > 0)
+			&& (args.checkpointSteps() > 0 || args.checkpointInterval() > 0 || !args.restart().empty()))
+		tools::Logger::logger.error("Checkpoints are only available for the uniform grid");
+	if (args.amrLevels() > 0 && args.ltsLevels() > 0)
+		tools::Logger::logger.error("Adaptive grids can not be combined with local time stepping");
+	if ((args.members() > 0 || args.amrLevels() > 0 || args.ltsLevels() > 0) && args.activeBlocks())
+		tools::Logger::logger.error("Active blocks are only available for the uniform grid");
+	if (!args.activeBlocks() && args.sleepThreshold() != 0)
+		tools::Logger::logger.warning("The sleep threshold is ignored without active blocks");
+	if ((args.members() > 0 || args.amrLevels() > 0 || args.ltsLevels() > 0 || tools::Mpi::ranks() > 1)
+			&& !args.profileJson().empty())
+		tools::Logger::logger.error("The profile is only written for the uniform grid on one process");
+	if ((args.members() > 0 || args.amrLevels() > 0 || args.ltsLevels() > 0 || tools::Mpi::ranks() > 1)
+			&& args.counters())
+		tools::Logger::logger.error("Hardware counters are only measured for the uniform grid on one process");
+	if (args.members() > 0 && !args.bathymetry().empty())
+		tools::Logger::logger.error("Ensembles can not be initialized from a bathymetry profile");
+	if (tools::Mpi::ranks() > 1 && (args.members() > 0 || args.amrLevels() > 0 || args.ltsLevels() > 0
+			|| args.checkpointSteps() > 0 || args.checkpointInterval() > 0 || !args.restart().empty()
+			|| args.fused() || args.activeBlocks()))
+		tools::Logger::logger.error("Distributed domains only support the uniform grid with separate passes");
+
+	switch (args.precision())
+	{
+		case tools::Args::DOUBLE:
+			tools::Logger::logger.info("Using double precision");
+			return run<double, double>(args);
+		case tools::Args::MIXED:
+			tools::Logger::logger.info("Using single precision storage with double precision computation");
+			return run<float, double>(args);
+		default:
+			tools::Logger::logger.info("Using single precision");
+			return run<float, float>(args);
+	}
+}
@@ -0,0 +1,71 @@
+/**
+ * @file CheckpointReader.cpp
+ * @brief Implementation of reader::CheckpointReader
+ */
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "CheckpointReader.hpp"
+
+reader::CheckpointReader::CheckpointReader(const std::string &fileName)
+	: m_data(0L), m_size(0)
+{
+	int fd = open(fileName.c_str(), O_RDONLY);
+	if (fd < 0) {
+		fail("Could not open " + fileName);
+		return;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(writer::CheckpointHeader)) {
+		close(fd);
+		fail("File too small: " + fileName);
+		return;
+	}
+
+	m_size = st.st_size;
+	void *data = mmap(0L, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		m_size = 0;
+		fail("Could not map " + fileName);
+		return;
+	}
+	m_data = static_cast<const char*>(data);
+
+	const writer::CheckpointHeader &h = header();
+	if (std::memcmp(h.magic, writer::CHECKPOINT_MAGIC, sizeof(writer::CHECKPOINT_MAGIC)) != 0) {
+		fail("Not a checkpoint file: " + fileName);
+		return;
+	}
+	if (h.version != writer::CHECKPOINT_VERSION) {
+		fail("Unsupported version: " + fileName);
+		return;
+	}
+	if (h.fields != writer::CHECKPOINT_FIELDS || h.fileSize != m_size
+			|| h.dataOffset + h.fields * writer::checkpointFieldSize(h.cells, h.scalarSize) > m_size) {
+		fail("Incomplete checkpoint: " + fileName);
+		return;
+	}
+
+	// The fields are read once from start to end
+	madvise(const_cast<char*>(m_data), m_size, MADV_SEQUENTIAL);
+}
+
+reader::CheckpointReader::~CheckpointReader()
+{
+	if (m_data)
+		munmap(const_cast<char*>(m_data), m_size);
+}
+
+void reader::CheckpointReader::fail(const std::string &message)
+{
+	if (m_data)
+		munmap(const_cast<char*>(m_data), m_size);
+	m_data = 0L;
+	m_size = 0;
+	m_error = message;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file CheckpointReader.hpp
+ * @brief Reads checkpoints for restarts
+ */
+
+#ifndef READER_CHECKPOINTREADER_H_
+#define READER_CHECKPOINTREADER_H_
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include "../writer/CheckpointFormat.hpp"
+
+namespace reader
+{
+
+	/**
+	 * @brief Memory maps a file written by writer::CheckpointWriter
+	 *
+	 * The header is validated when the file is mapped, the fields can be
+	 * accessed without copying.
+	 */
+	class CheckpointReader
+	{
+
+	private:
+
+		/** @brief Start of the mapped file, 0 if the file could not be opened */
+		const char *m_data;
+
+		/** @brief Size of the mapped file */
+		size_t m_size;
+
+		/** @brief Description of the last error */
+		std::string m_error;
+
+	public:
+
+		/**
+		 * @brief Constructor, maps the file
+		 *
+		 * @param fileName The name of the checkpoint file
+		 */
+		CheckpointReader(const std::string &fileName);
+
+		/**
+		 * @brief Destructor, unmaps the file
+		 */
+		~CheckpointReader();
+
+		/**
+		 * @brief Whether the file was mapped successfully
+		 */
+		bool good() const
+		{
+			return m_data != 0L;
+		}
+
+		/**
+		 * @brief Description of the error if the file could not be mapped
+		 */
+		const std::string& error() const
+		{
+			return m_error;
+		}
+
+		/**
+		 * @brief The header of the file
+		 */
+		const writer::CheckpointHeader& header() const
+		{
+			return *reinterpret_cast<const writer::CheckpointHeader*>(m_data);
+		}
+
+		/**
+		 * @brief The name of the scenario
+		 */
+		std::string scenario() const
+		{
+			return std::string(header().scenario, strnlen(header().scenario, sizeof(header().scenario)));
+		}
+
+		/**
+		 * @brief The values of a field
+		 *
+		 * @param field The number of the field (h, hu, b)
+		 *
+		 * @return Pointer to cells+2 values (with boundary values), 0 if S does not
+		 *         match the precision of the file
+		 */
+		template<typename S> const S* field(unsigned int field) const
+		{
+			if (sizeof(S) != header().scalarSize || field >= header().fields)
+				return 0L;
+
+			return reinterpret_cast<const S*>(m_data + header().dataOffset
+				+ field * writer::checkpointFieldSize(header().cells, header().scalarSize));
+		}
+
+	private:
+
+		/**
+		 * @brief Unmaps the file and stores an error message
+		 */
+		void fail(const std::string &message);
+
+	};
+
+}
+
+#endif /* READER_CHECKPOINTREADER_H_ */
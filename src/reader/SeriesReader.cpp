@@ -0,0 +1,101 @@
+/**
+ * @file SeriesReader.cpp
+ * @brief Implementation of reader::SeriesReader
+ */
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "SeriesReader.hpp"
+
+reader::SeriesReader::SeriesReader(const std::string &fileName)
+	: m_data(0L), m_size(0), m_steps(0), m_index(0L)
+{
+	int fd = open(fileName.c_str(), O_RDONLY);
+	if (fd < 0) {
+		fail("Could not open " + fileName);
+		return;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(writer::SeriesHeader)) {
+		close(fd);
+		fail("File too small: " + fileName);
+		return;
+	}
+
+	m_size = st.st_size;
+	void *data = mmap(0L, m_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		m_size = 0;
+		fail("Could not map " + fileName);
+		return;
+	}
+	m_data = static_cast<const char*>(data);
+
+	const writer::SeriesHeader &h = header();
+	if (std::memcmp(h.magic, writer::SERIES_MAGIC, sizeof(writer::SERIES_MAGIC)) != 0) {
+		fail("Not a series file: " + fileName);
+		return;
+	}
+	if (h.version != writer::SERIES_VERSION) {
+		fail("Unsupported version: " + fileName);
+		return;
+	}
+
+	if (h.indexOffset != 0 && h.indexOffset + h.steps * sizeof(writer::SeriesIndexEntry) <= m_size) {
+		m_index = reinterpret_cast<const writer::SeriesIndexEntry*>(m_data + h.indexOffset);
+		m_steps = h.steps;
+	} else if (h.blockSize > 0) {
+		// Not closed properly, use all complete blocks
+		m_steps = (m_size - h.dataOffset) / h.blockSize;
+	}
+
+	// Advise the kernel that steps are accessed randomly
+	madvise(const_cast<char*>(m_data), m_size, MADV_RANDOM);
+}
+
+reader::SeriesReader::~SeriesReader()
+{
+	if (m_data)
+		munmap(const_cast<char*>(m_data), m_size);
+}
+
+int reader::SeriesReader::fieldId(const std::string &name) const
+{
+	for (unsigned int i = 0; i < header().fields && i < writer::SERIES_MAX_FIELDS; i++) {
+		if (name.compare(0, sizeof(header().fieldNames[i]), header().fieldNames[i]) == 0
+				&& name.size() == strnlen(header().fieldNames[i], sizeof(header().fieldNames[i])))
+			return i;
+	}
+	return -1;
+}
+
+unsigned long long reader::SeriesReader::findStep(double time) const
+{
+	// Time is increasing, find the last step with time(step) <= time
+	unsigned long long first = 0;
+	unsigned long long last = m_steps;
+	while (last - first > 1) {
+		unsigned long long middle = first + (last - first) / 2;
+		if (this->time(middle) <= time)
+			first = middle;
+		else
+			last = middle;
+	}
+	return first;
+}
+
+void reader::SeriesReader::fail(const std::string &message)
+{
+	if (m_data)
+		munmap(const_cast<char*>(m_data), m_size);
+	m_data = 0L;
+	m_size = 0;
+	m_steps = 0;
+	m_index = 0L;
+	m_error = message;
+}
@@ -0,0 +1,174 @@
+/**
+ * @file SeriesReader.hpp
+ * @brief Random access to the time steps of a series file
+ */
+
+#ifndef READER_SERIESREADER_H_
+#define READER_SERIESREADER_H_
+
+#include <cstddef>
+#include <string>
+#include "../writer/SeriesFormat.hpp"
+
+/**
+ * @brief Readers for the output of the framework
+ */
+namespace reader
+{
+
+	/**
+	 * @brief Memory maps a file written by writer::SeriesWriter
+	 *
+	 * Every time step and field can be accessed in O(1) without copying.
+	 * Files that were not closed properly (no index) can be read as well,
+	 * all complete time steps are available.
+	 */
+	class SeriesReader
+	{
+
+	private:
+
+		/** @brief Start of the mapped file, 0 if the file could not be opened */
+		const char *m_data;
+
+		/** @brief Size of the mapped file */
+		size_t m_size;
+
+		/** @brief Number of complete time steps */
+		unsigned long long m_steps;
+
+		/** @brief The index, 0 if the file was not closed properly */
+		const writer::SeriesIndexEntry *m_index;
+
+		/** @brief Description of the last error */
+		std::string m_error;
+
+	public:
+
+		/**
+		 * @brief Constructor, maps the file
+		 *
+		 * @param fileName The name of the series file
+		 */
+		SeriesReader(const std::string &fileName);
+
+		/**
+		 * @brief Destructor, unmaps the file
+		 */
+		~SeriesReader();
+
+		/**
+		 * @brief Whether the file was mapped successfully
+		 */
+		bool good() const
+		{
+			return m_data != 0L;
+		}
+
+		/**
+		 * @brief Description of the error if the file could not be mapped
+		 */
+		const std::string& error() const
+		{
+			return m_error;
+		}
+
+		/**
+		 * @brief The header of the file
+		 */
+		const writer::SeriesHeader& header() const
+		{
+			return *reinterpret_cast<const writer::SeriesHeader*>(m_data);
+		}
+
+		/**
+		 * @brief Number of cells (without boundary values)
+		 */
+		unsigned int cells() const
+		{
+			return header().cells;
+		}
+
+		/**
+		 * @brief Number of time steps in the file
+		 */
+		unsigned long long steps() const
+		{
+			return m_steps;
+		}
+
+		/**
+		 * @brief Finds a field by name
+		 *
+		 * @param name The name of the field (h, hu, b or f)
+		 *
+		 * @return The number of the field or -1 if it does not exist
+		 */
+		int fieldId(const std::string &name) const;
+
+		/**
+		 * @brief The simulation time of a time step
+		 *
+		 * @param step The number of the time step
+		 */
+		double time(unsigned long long step) const
+		{
+			return stepHeader(step).time;
+		}
+
+		/**
+		 * @brief Finds the last time step at or before a simulation time (binary search)
+		 *
+		 * @param time The simulation time
+		 *
+		 * @return The number of the time step, 0 if time is before the first step
+		 */
+		unsigned long long findStep(double time) const;
+
+		/**
+		 * @brief The values of a field at a time step
+		 *
+		 * @param step The number of the time step
+		 * @param field The number of the field
+		 *
+		 * @return Pointer to cells() values, 0 if S does not match the precision of the file
+		 */
+		template<typename S> const S* field(unsigned long long step, unsigned int field) const
+		{
+			if (sizeof(S) != header().scalarSize || field >= header().fields || step >= m_steps)
+				return 0L;
+
+			return reinterpret_cast<const S*>(m_data + stepOffset(step) + sizeof(writer::SeriesStepHeader)
+				+ field * writer::seriesFieldSize(header().cells, header().scalarSize));
+		}
+
+	private:
+
+		/**
+		 * @brief Offset of a time step block in the file
+		 */
+		unsigned long long stepOffset(unsigned long long step) const
+		{
+			if (m_index)
+				return m_index[step].offset;
+			return header().dataOffset + step * header().blockSize;
+		}
+
+		/**
+		 * @brief The header of a time step block
+		 */
+		const writer::SeriesStepHeader& stepHeader(unsigned long long step) const
+		{
+			return *reinterpret_cast<const writer::SeriesStepHeader*>(m_data + stepOffset(step));
+		}
+
+		/**
+		 * @brief Unmaps the file and stores an error message
+		 */
+		void fail(const std::string &message);
+
+	};
+
+}
+
+#endif /* READER_SERIESREADER_H_ */
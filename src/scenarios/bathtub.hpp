@@ -7,7 +7,6 @@
 #define SCENARIOS_BATHTUB_H_
 
 #include <cmath>
-#include "../types.hpp"
 
 namespace scenarios
 {
@@ -15,7 +14,7 @@ namespace scenarios
 	/**
 	 * @brief Implementation of the Bathtub scenario
 	 */
-	class Bathtub
+	template<typename T> class Bathtub
 	{
 
 	private:
@@ -24,6 +23,8 @@ namespace scenarios
 		const unsigned int m_size;
 		/** @brief Point of collision (here: in the middle) */
 		const unsigned int m_xdis = m_size/2;
+		/** @brief Depth of the basin in the middle of the domain */
+		const T m_depth;
 	
 	public:
 
@@ -31,9 +32,10 @@ namespace scenarios
 		 * @brief Constructor
 		 * 
 		 * @param size The size of the domain
+		 * @param depth The depth of the basin in the middle of the domain
 		 */
-		Bathtub(unsigned int size) //, std::vector<int> options)
-			: m_size(size) //, m_options(options)
+		Bathtub(unsigned int size, T depth = 30) //, std::vector<int> options)
+			: m_size(size), m_depth(depth) //, m_options(options)
 		{
 		}
 
@@ -44,9 +46,9 @@ namespace scenarios
 		 * 
 		 * @return The initial water height above the bathymetry
 		 */
-		float getHeight(unsigned int pos)
+		T getHeight(unsigned int pos)
 		{
-			if (std::abs(pos - m_size/2) < 15) return 20;
+			if (std::abs((int) pos - (int) m_size/2) < 15) return 20;
 			if(pos <= 5 || (m_size - pos) < 5) return 0;
 			return 10;
 		}
@@ -58,7 +60,7 @@ namespace scenarios
 		 * 
 		 * @return The initial water speed
 		 */
-		float getSpeed(unsigned int pos)
+		T getSpeed(unsigned int pos)
 		{
 		    return 0;
 		}
@@ -70,9 +72,9 @@ namespace scenarios
 		 * 
 		 * @return The initial bathymetry
 		 */
-		float getBathy(unsigned int pos)
+		T getBathy(unsigned int pos)
 		{
-			if (std::abs(pos - m_size/2) < 30) return -30;
+			if (std::abs((int) pos - (int) m_size/2) < 30) return -m_depth;
 			if(pos <= 5 || (m_size - pos) < 5) return 30;
 			return 0;
 		}
@@ -86,7 +88,7 @@ namespace scenarios
 		 */
 		T getCellSize()
 		{
-			return 1000.f / m_size;
+			return (T) 1000 / m_size;
 		}
 
 	};
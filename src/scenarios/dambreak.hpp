@@ -7,7 +7,6 @@
 #define SCENARIOS_DAMBREAK_H_
 
 // #include <vector>
-#include "../types.hpp"
 
 /**
  * @brief Scenarios for the 1D solver
@@ -18,7 +17,7 @@ namespace scenarios
 	/**
 	 * @brief Implementation of the Dam break scenario
 	 */
-	class DamBreak
+	template<typename T> class DamBreak
 	{
 
 	private:
@@ -28,9 +27,9 @@ namespace scenarios
 		/** @brief Point of collision (here: in the middle) */
 		const unsigned int m_xdis = m_size/2;
 		/** @brief initial water height left of xdis*/
-		const float m_leftHeight = 20;
+		const T m_leftHeight;
 		/** @brief initial water height righr of xdis*/
-		const float m_rightHeight = 5;
+		const T m_rightHeight;
 		/** @brief initial water speed left of xdis */
 		const float m_leftSpeed = 0;
 		/** @brief initial water speed right of xdis */
@@ -56,9 +55,11 @@ namespace scenarios
 		 * @brief Constructor
 		 * 
 		 * @param size The size of the domain
+		 * @param leftHeight The initial water height left of the dam
+		 * @param rightHeight The initial water height right of the dam
 		 */
-		DamBreak(unsigned int size) //, std::vector<int> options)
-			: m_size(size) //, m_options(options)
+		DamBreak(unsigned int size, T leftHeight = 20, T rightHeight = 5) //, std::vector<int> options)
+			: m_size(size), m_leftHeight(leftHeight), m_rightHeight(rightHeight) //, m_options(options)
 		{
 		}
 
@@ -69,7 +70,7 @@ namespace scenarios
 		 * 
 		 * @return The initial water height above the bathymetry
 		 */
-		float getHeight(unsigned int pos)
+		T getHeight(unsigned int pos)
 		{
 			if (pos <= m_size/2) return m_leftHeight;
 			return m_rightHeight;
@@ -82,7 +83,7 @@ namespace scenarios
 		 * 
 		 * @return The initial water speed
 		 */
-		float getSpeed(unsigned int pos)
+		T getSpeed(unsigned int pos)
 		{
 			if (pos <= m_xdis) return m_leftSpeed;
 			return m_rightSpeed; 
@@ -95,7 +96,7 @@ namespace scenarios
 		 * 
 		 * @return The initial bathymetry
 		 */
-		float getBathy(unsigned int pos)
+		T getBathy(unsigned int pos)
 		{
 			if (pos <= m_lbdis) return m_leftB;
 			else if (pos <= m_rbdis) return m_middleB;
@@ -111,7 +112,7 @@ namespace scenarios
 		 */
 		T getCellSize()
 		{
-			return 1000.f / m_size;
+			return (T) 1000 / m_size;
 		}
 
 	};
@@ -0,0 +1,81 @@
+/**
+ * @file fill.hpp
+ * @brief Bulk initialization of the unknowns from a scenario
+ */
+
+#ifndef SCENARIOS_FILL_H_
+#define SCENARIOS_FILL_H_
+
+#include "../tools/threads.hpp"
+#include "../../submodules/solvers/src/solver/FWave.hpp"
+
+namespace scenarios
+{
+
+	/**
+	 * @brief Writes the initial values of the cells [first, last) of a scenario
+	 *
+	 * The default implementation evaluates the getters of the scenario, one loop
+	 * per field so the compiler can inline and vectorize them. Scenarios with a
+	 * faster way of producing a whole range provide an overload.
+	 *
+	 * @param scenario The scenario
+	 * @param first The first cell (0 is the left boundary)
+	 * @param last One past the last cell
+	 * @param[out] h The surface level (as returned by getHeight)
+	 * @param[out] hu The momentum
+	 * @param[out] b The bathymetry
+	 */
+	template<class Scenario, typename T> void fill(Scenario &scenario, unsigned int first, unsigned int last,
+		T *h, T *hu, T *b)
+	{
+		for (unsigned int i = first; i < last; i++)
+			b[i] = scenario.getBathy(i);
+		for (unsigned int i = first; i < last; i++)
+			h[i] = scenario.getHeight(i);
+		for (unsigned int i = first; i < last; i++)
+			hu[i] = scenario.getSpeed(i);
+	}
+
+	/**
+	 * @brief Initializes the unknowns of a domain in parallel
+	 *
+	 * Every thread fills its own chunk, which also places the memory close to the
+	 * thread that works on it later. The water height is the surface level minus
+	 * the bathymetry, cells below ZERO_PRECISION are dry.
+	 *
+	 * A process that holds only a slab of the domain passes the global index of
+	 * its left boundary cell as offset.
+	 *
+	 * @param scenario The scenario
+	 * @param size Number of cells (without the boundary cells)
+	 * @param[out] h Water heights
+	 * @param[out] hu Momentums
+	 * @param[out] b Bathymetries
+	 * @param threads Number of threads
+	 * @param offset The cell of the scenario that is stored at index 0
+	 */
+	template<class Scenario, typename T> void initialize(Scenario &scenario, unsigned int size,
+		T *h, T *hu, T *b, unsigned int threads = 1, unsigned int offset = 0)
+	{
+		#pragma omp parallel num_threads(threads > 0 ? threads : 1)
+		{
+			unsigned int begin, end;
+			tools::getChunk(0, size+2, begin, end);
+
+			// The scenario is indexed globally
+			fill(scenario, offset+begin, offset+end, h-offset, hu-offset, b-offset);
+
+			for (unsigned int i = begin; i < end; i++)
+			{
+				// The water height is given as surface level, not water volume
+				h[i] -= b[i];
+				if (h[i] < ZERO_PRECISION)
+					h[i] = 0;
+			}
+		}
+	}
+
+}
+
+#endif /* SCENARIOS_FILL_H_ */
@@ -6,7 +6,6 @@
 #ifndef SCENARIOS_HYDRAULICSUB_H_
 #define SCENARIOS_HYDRAULICSUB_H_
 
-#include "../types.hpp"
 
 namespace scenarios
 {
@@ -14,7 +13,7 @@ namespace scenarios
 	/**
 	 * @brief Implementation of the hydraulic subcritical scenario
 	 */
-	class HydraulicSub
+	template<typename T> class HydraulicSub
 	{
 
 	private:
@@ -89,7 +88,7 @@ namespace scenarios
 		 */
 		T getCellSize()
 		{
-			return 1000.f / m_size;
+			return (T) 1000 / m_size;
 		}
 
 	};
@@ -6,7 +6,6 @@
 #ifndef SCENARIOS_HYDRAULICSUP_H_
 #define SCENARIOS_HYDRAULICSUP_H_
 
-#include "../types.hpp"
 
 namespace scenarios
 {
@@ -14,7 +13,7 @@ namespace scenarios
 	/**
 	 * @brief Implementation of the hydraulic supercritical scenario
 	 */
-	class HydraulicSup
+	template<typename T> class HydraulicSup
 	{
 
 	private:
@@ -88,7 +87,7 @@ namespace scenarios
 		 */
 		T getCellSize()
 		{
-			return 1000.f / m_size;
+			return (T) 1000 / m_size;
 		}
 
 	};
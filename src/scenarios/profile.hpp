@@ -0,0 +1,373 @@
+/**
+ * @file profile.hpp
+ * @brief Scenario read from a bathymetry and initial condition profile
+ */
+
+#ifndef SCENARIOS_PROFILE_H_
+#define SCENARIOS_PROFILE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace scenarios
+{
+
+	/**
+	 * @brief Scenario with the bathymetry, surface level and momentum of a file
+	 *
+	 * The profile consists of N samples evenly spaced from the left to the right
+	 * end of the domain, each with the columns bathymetry, surface level and
+	 * momentum. Two formats are supported:
+	 * - raw binary (*.f32, *.f64): the three columns of each sample next to each
+	 *   other as native float or double values, without a header. The file is
+	 *   memory-mapped and only the samples of a range are touched by fill().
+	 * - text (any other extension): one sample per line with whitespace separated
+	 *   columns, lines starting with # are skipped. If only the bathymetry is
+	 *   given, the surface level is 0 (sealevel), a missing momentum is 0.
+	 *   Lines that are not one to three numbers are an error.
+	 *
+	 * The samples are resampled onto the grid: if the grid is finer than the
+	 * profile, the values are interpolated linearly at the cell centers, otherwise
+	 * all samples inside a cell are averaged. The boundary cells copy their
+	 * neighbours.
+	 */
+	template<typename T> class Profile
+	{
+
+	private:
+
+		/** @brief Number of columns of a sample */
+		static const unsigned int COLUMNS = 3;
+
+		/** @brief Number of cells */
+		const unsigned int m_size;
+		/** @brief Length of the domain */
+		const T m_length;
+
+		/** @brief The mapped raw file */
+		void *m_map;
+		/** @brief Size of the mapped file */
+		size_t m_mapSize;
+		/** @brief Samples of a text file */
+		std::vector<double> m_text;
+
+		/** @brief The samples, float if m_float, double otherwise */
+		const void *m_samples;
+		/** @brief Whether the samples are stored as float */
+		bool m_float;
+		/** @brief Number of samples */
+		unsigned long long m_count;
+
+		/** @brief Error message, empty if the profile was read */
+		std::string m_error;
+
+	public:
+
+		/**
+		 * @brief Constructor, maps or reads the profile
+		 *
+		 * @param size The size of the domain
+		 * @param fileName The profile
+		 * @param length The length of the domain
+		 */
+		Profile(unsigned int size, const std::string &fileName, T length = 1000)
+			: m_size(size), m_length(length), m_map(0L), m_mapSize(0),
+			  m_samples(0L), m_float(false), m_count(0)
+		{
+			const std::string::size_type dot = fileName.rfind('.');
+			const std::string extension = dot == std::string::npos ? "" : fileName.substr(dot);
+			if (extension == ".f32" || extension == ".f64")
+				map(fileName, extension == ".f32");
+			else
+				read(fileName);
+
+			if (m_error.empty() && m_count == 0)
+				m_error = "No samples in " + fileName;
+		}
+
+		/**
+		 * @brief Destructor, unmaps the file
+		 */
+		~Profile()
+		{
+			if (m_map)
+				munmap(m_map, m_mapSize);
+		}
+
+		/**
+		 * @brief Whether the profile could be read
+		 */
+		bool good() const
+		{
+			return m_error.empty();
+		}
+
+		/**
+		 * @brief The reason why the profile could not be read
+		 */
+		const std::string& error() const
+		{
+			return m_error;
+		}
+
+		/**
+		 * @brief Number of samples in the profile
+		 */
+		unsigned long long samples() const
+		{
+			return m_count;
+		}
+
+		/**
+		 * @brief Generates the water height
+		 *
+		 * @param pos The cell position
+		 *
+		 * @return The initial surface level
+		 */
+		T getHeight(unsigned int pos)
+		{
+			return value(pos, 1);
+		}
+
+		/**
+		 * @brief Generates the water speed
+		 *
+		 * @param pos The cell position
+		 *
+		 * @return The initial momentum
+		 */
+		T getSpeed(unsigned int pos)
+		{
+			return value(pos, 2);
+		}
+
+		/**
+		 * @brief Generates the bathymetry
+		 *
+		 * @param pos The cell position
+		 *
+		 * @return The initial bathymetry
+		 */
+		T getBathy(unsigned int pos)
+		{
+			return value(pos, 0);
+		}
+
+		/**
+		 * @brief Computes the cell size
+		 *
+		 * Calculates domain size / number of cells
+		 *
+		 * @return Cell size of one cell
+		 */
+		T getCellSize()
+		{
+			return m_length / m_size;
+		}
+
+		/**
+		 * @brief Resamples the profile onto the cells [first, last)
+		 *
+		 * @see scenarios::fill
+		 */
+		void fill(unsigned int first, unsigned int last, T *h, T *hu, T *b)
+		{
+			if (m_float)
+				resample(static_cast<const float*>(m_samples), first, last, h, hu, b);
+			else
+				resample(static_cast<const double*>(m_samples), first, last, h, hu, b);
+		}
+
+	private:
+
+		/**
+		 * @brief Resamples one column at one cell
+		 */
+		T value(unsigned int pos, unsigned int column) const
+		{
+			double values[COLUMNS];
+			if (m_float)
+				sample(static_cast<const float*>(m_samples), pos, values);
+			else
+				sample(static_cast<const double*>(m_samples), pos, values);
+			return values[column];
+		}
+
+		/**
+		 * @brief Resamples all columns of a range of cells
+		 *
+		 * @param samples The samples of the profile
+		 */
+		template<typename S> void resample(const S *samples, unsigned int first, unsigned int last,
+			T *h, T *hu, T *b) const
+		{
+			for (unsigned int i = first; i < last; i++)
+			{
+				double values[COLUMNS];
+				sample(samples, i, values);
+				b[i] = values[0];
+				h[i] = values[1];
+				hu[i] = values[2];
+			}
+		}
+
+		/**
+		 * @brief Resamples all columns at one cell
+		 *
+		 * @param samples The samples of the profile
+		 * @param pos The cell position
+		 * @param[out] values The bathymetry, surface level and momentum
+		 */
+		template<typename S> void sample(const S *samples, unsigned int pos, double *values) const
+		{
+			// Boundary cells copy their neighbours
+			const unsigned int cell = std::min(std::max(pos, 1u), m_size) - 1;
+			// Samples per cell
+			const double ratio = m_count > 1 ? (double) (m_count-1) / m_size : 0;
+
+			if (ratio <= 1)
+			{
+				// Linear interpolation at the cell center
+				const double x = (cell + .5) * ratio;
+				const unsigned long long j = std::min<unsigned long long>(x, m_count > 1 ? m_count-2 : 0);
+				const unsigned long long k = std::min(j+1, m_count-1);
+				const double w = x - j;
+				for (unsigned int c = 0; c < COLUMNS; c++)
+					values[c] = (1-w) * samples[j*COLUMNS+c] + w * samples[k*COLUMNS+c];
+				return;
+			}
+
+			// Average of the samples inside the cell
+			const unsigned long long j = std::ceil(cell * ratio);
+			const unsigned long long k = cell+1 == m_size ? m_count
+				: std::max<unsigned long long>(std::ceil((cell+1) * ratio), j+1);
+			for (unsigned int c = 0; c < COLUMNS; c++)
+				values[c] = 0;
+			for (unsigned long long s = j; s < k; s++)
+				for (unsigned int c = 0; c < COLUMNS; c++)
+					values[c] += samples[s*COLUMNS+c];
+			for (unsigned int c = 0; c < COLUMNS; c++)
+				values[c] /= k - j;
+		}
+
+		/**
+		 * @brief Maps a raw binary profile
+		 *
+		 * @param fileName The profile
+		 * @param single Whether the samples are stored as float
+		 */
+		void map(const std::string &fileName, bool single)
+		{
+			m_float = single;
+
+			int fd = open(fileName.c_str(), O_RDONLY);
+			if (fd < 0) {
+				m_error = "Could not open " + fileName;
+				return;
+			}
+
+			struct stat st;
+			const size_t sampleSize = COLUMNS * (single ? sizeof(float) : sizeof(double));
+			if (fstat(fd, &st) != 0 || st.st_size == 0 || st.st_size % sampleSize != 0) {
+				close(fd);
+				m_error = "Not a profile with " + std::string(single ? "float" : "double")
+					+ " triples: " + fileName;
+				return;
+			}
+
+			m_mapSize = st.st_size;
+			void *data = mmap(0L, m_mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+			close(fd);
+			if (data == MAP_FAILED) {
+				m_mapSize = 0;
+				m_error = "Could not map " + fileName;
+				return;
+			}
+
+			// Every sample is read once, in order within each thread's chunk
+			madvise(data, m_mapSize, MADV_SEQUENTIAL);
+
+			m_map = data;
+			m_samples = data;
+			m_count = m_mapSize / sampleSize;
+		}
+
+		/**
+		 * @brief Reads a text profile
+		 *
+		 * @param fileName The profile
+		 */
+		void read(const std::string &fileName)
+		{
+			std::ifstream in(fileName.c_str());
+			if (!in.good()) {
+				m_error = "Could not open " + fileName;
+				return;
+			}
+
+			std::string line;
+			unsigned long long lineNumber = 0;
+			while (std::getline(in, line))
+			{
+				lineNumber++;
+				const char *p = line.c_str();
+				while (*p == ' ' || *p == '\t')
+					p++;
+				if (*p == '#' || *p == '\0' || *p == '\r')
+					continue;
+
+				// Bathymetry, surface level (sealevel) and momentum (at rest)
+				double values[COLUMNS] = {0, 0, 0};
+				unsigned int columns = 0;
+				for (; columns < COLUMNS; columns++)
+				{
+					char *end;
+					values[columns] = std::strtod(p, &end);
+					if (end == p)
+						break;
+					p = end;
+				}
+
+				// Nothing but whitespace may follow the numbers
+				while (*p == ' ' || *p == '\t' || *p == '\r')
+					p++;
+				if (columns == 0 || *p != '\0') {
+					std::ostringstream error;
+					error << fileName << ":" << lineNumber << ": Could not parse the sample \"" << line << "\"";
+					m_error = error.str();
+					return;
+				}
+
+				m_text.insert(m_text.end(), values, values+COLUMNS);
+			}
+
+			m_samples = m_text.data();
+			m_count = m_text.size() / COLUMNS;
+		}
+
+	};
+
+	/**
+	 * @brief Resamples a profile onto the cells [first, last)
+	 *
+	 * @see scenarios::fill
+	 */
+	template<typename T> void fill(Profile<T> &scenario, unsigned int first, unsigned int last,
+		T *h, T *hu, T *b)
+	{
+		scenario.fill(first, last, h, hu, b);
+	}
+
+}
+
+#endif /* SCENARIOS_PROFILE_H_ */
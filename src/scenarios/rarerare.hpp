@@ -6,7 +6,6 @@
 #ifndef SCENARIOS_RARERARE_H_
 #define SCENARIOS_RARERARE_H_
 
-#include "../types.hpp"
 
 namespace scenarios
 {
@@ -14,7 +13,7 @@ namespace scenarios
 	/**
 	 * @brief Implementation of the Rare-Rare scenario
 	 */
-	class RareRare
+	template<typename T> class RareRare
 	{
 
 	private:
@@ -49,7 +48,7 @@ namespace scenarios
 		 * 
 		 * @return The initial water height above the bathymetry
 		 */
-		unsigned int getHeight(unsigned int pos)
+		T getHeight(unsigned int pos)
 		{
 			return m_height;
 		}
@@ -61,7 +60,7 @@ namespace scenarios
 		 * 
 		 * @return The initial water speed
 		 */
-		signed int getSpeed(unsigned int pos)
+		T getSpeed(unsigned int pos)
 		{
 			if (pos <= m_xdis) return m_leftSpeed;
 			return m_rightSpeed; // switch left and right 10 for shock-shock
@@ -74,7 +73,7 @@ namespace scenarios
 		 * 
 		 * @return The initial bathymetry
 		 */
-		float getBathy(unsigned int pos)
+		T getBathy(unsigned int pos)
 		{
 			return 0;
 		}
@@ -88,7 +87,7 @@ namespace scenarios
 		 */
 		T getCellSize()
 		{
-			return 1000.f / m_size;
+			return (T) 1000 / m_size;
 		}
 
 	};
@@ -0,0 +1,141 @@
+/**
+ * @file registry.hpp
+ * @brief Runtime selection of the scenarios
+ */
+
+#ifndef SCENARIOS_REGISTRY_H_
+#define SCENARIOS_REGISTRY_H_
+
+#include <string>
+#include <vector>
+#include "bathtub.hpp"
+#include "dambreak.hpp"
+#include "shockshock.hpp"
+#include "rarerare.hpp"
+#include "hydraulicsub.hpp"
+#include "hydraulicsup.hpp"
+
+namespace scenarios
+{
+
+	/**
+	 * @brief The scenarios that can be selected at runtime
+	 */
+	enum Type { BATHTUB, DAMBREAK, SHOCKSHOCK, RARERARE, HYDRAULICSUB, HYDRAULICSUP, TYPES };
+
+	/**
+	 * @brief Name and parameters of a scenario
+	 */
+	struct Description
+	{
+		/** @brief Name used on the command line */
+		const char *name;
+		/** @brief Names of the parameters, for the help message */
+		const char *parameters;
+		/** @brief Number of parameters */
+		unsigned int parameterCount;
+		/** @brief Values of the parameters that are not given */
+		double defaults[2];
+	};
+
+	/**
+	 * @brief The descriptions of all scenarios, indexed by Type
+	 */
+	inline const Description& describe(Type type)
+	{
+		static const Description descriptions[TYPES] = {
+			{"bathtub", "DEPTH (30)", 1, {30, 0}},
+			{"dambreak", "LEFT:RIGHT water heights (20:5)", 2, {20, 5}},
+			{"shockshock", "", 0, {0, 0}},
+			{"rarerare", "", 0, {0, 0}},
+			{"hydraulicsub", "", 0, {0, 0}},
+			{"hydraulicsup", "", 0, {0, 0}}
+		};
+		return descriptions[type];
+	}
+
+	/**
+	 * @brief Finds a scenario by its name
+	 *
+	 * @param name The name
+	 * @param[out] type The scenario
+	 *
+	 * @return False if there is no scenario with this name
+	 */
+	inline bool find(const std::string &name, Type &type)
+	{
+		for (unsigned int i = 0; i < TYPES; i++)
+		{
+			if (name == describe(static_cast<Type>(i)).name)
+			{
+				type = static_cast<Type>(i);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/**
+	 * @brief A parameter of a scenario, or its default
+	 */
+	inline double parameter(Type type, const std::vector<double> &parameters, unsigned int i)
+	{
+		return i < parameters.size() ? parameters[i] : describe(type).defaults[i];
+	}
+
+	/**
+	 * @brief Creates a scenario and passes it to a driver
+	 *
+	 * The driver is called with the concrete scenario class, so every scenario gets
+	 * its own instantiation of the driver and the scenario is inlined into the
+	 * initialization. The driver has to provide
+	 * template<class Scenario> int operator()(Scenario &scenario).
+	 *
+	 * @param type The scenario
+	 * @param parameters The parameters of the scenario, missing ones are set to the defaults
+	 * @param size Number of cells
+	 * @param driver The driver
+	 *
+	 * @return The return value of the driver
+	 */
+	template<typename T, class Driver> int dispatch(Type type, const std::vector<double> &parameters,
+		unsigned int size, Driver &driver)
+	{
+		switch (type)
+		{
+			case BATHTUB:
+			{
+				Bathtub<T> scenario(size, parameter(type, parameters, 0));
+				return driver(scenario);
+			}
+			case DAMBREAK:
+			{
+				DamBreak<T> scenario(size, parameter(type, parameters, 0), parameter(type, parameters, 1));
+				return driver(scenario);
+			}
+			case SHOCKSHOCK:
+			{
+				ShockShock<T> scenario(size);
+				return driver(scenario);
+			}
+			case RARERARE:
+			{
+				RareRare<T> scenario(size);
+				return driver(scenario);
+			}
+			case HYDRAULICSUB:
+			{
+				HydraulicSub<T> scenario(size);
+				return driver(scenario);
+			}
+			default:
+			{
+				HydraulicSup<T> scenario(size);
+				return driver(scenario);
+			}
+		}
+	}
+
+}
+
+#endif /* SCENARIOS_REGISTRY_H_ */
@@ -6,7 +6,6 @@
 #ifndef SCENARIOS_SHOCKSHOCK_H_
 #define SCENARIOS_SHOCKSHOCK_H_
 
-#include "../types.hpp"
 
 namespace scenarios
 {
@@ -14,7 +13,7 @@ namespace scenarios
 	/**
 	 * @brief Implementation of the Shock-Shock scenario
 	 */
-	class ShockShock
+	template<typename T> class ShockShock
 	{
 
 	private:
@@ -50,7 +49,7 @@ namespace scenarios
 		 * 
 		 * @return The initial water height above the bathymetry
 		 */
-		unsigned int getHeight(unsigned int pos)
+		T getHeight(unsigned int pos)
 		{
 			if (pos <= m_xdis) return m_leftHeight;
 			return 0;
@@ -63,7 +62,7 @@ namespace scenarios
 		 * 
 		 * @return The initial water speed
 		 */
-		signed int getSpeed(unsigned int pos)
+		T getSpeed(unsigned int pos)
 		{
 			if (pos <= m_xdis) return m_leftSpeed;
 			return m_rightSpeed; 
@@ -76,7 +75,7 @@ namespace scenarios
 		 * 
 		 * @return The Initial bathymetry
 		 */
-		float getBathy(unsigned int pos)
+		T getBathy(unsigned int pos)
 		{
 			if (pos <= m_xdis) return 0;
 			return m_rightBathy;
@@ -91,7 +90,7 @@ namespace scenarios
 		 */
 		T getCellSize()
 		{
-			return 1000.f / m_size;
+			return (T) 1000 / m_size;
 		}
 
 	};
@@ -0,0 +1,132 @@
+/**
+ * @file activeblocks.hpp
+ * @brief Tracks the blocks of a domain that have to be computed
+ */
+
+#ifndef TOOLS_ACTIVEBLOCKS_H_
+#define TOOLS_ACTIVEBLOCKS_H_
+
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+
+namespace tools
+{
+
+	/**
+	 * @brief Bitmap of active blocks
+	 *
+	 * Every time step, the owner reports for each active block whether its cells
+	 * changed. ActiveBlocks::update starts the next time step, in which exactly the
+	 * blocks that changed and their neighbours are active: a block whose cells and
+	 * neighbour cells did not change has the same (zero) updates as before and can
+	 * sleep. Initially all blocks are active and count as changed.
+	 */
+	class ActiveBlocks
+	{
+
+	private:
+
+		/** @brief Number of blocks */
+		unsigned int m_blocks;
+
+		/** @brief One bit per block, set if the block is active */
+		std::vector<uint64_t> m_active;
+
+		/** @brief Blocks that changed in the current time step */
+		std::vector<unsigned char> m_changed;
+
+		/** @brief The indices of all active blocks */
+		std::vector<unsigned int> m_list;
+
+	public:
+
+		/**
+		 * @brief Constructor
+		 *
+		 * @param blocks Number of blocks
+		 */
+		ActiveBlocks(unsigned int blocks)
+			: m_blocks(blocks), m_active((blocks+63) / 64), m_changed(blocks, 1), m_list(blocks)
+		{
+			for (unsigned int i = 0; i < blocks; i++)
+			{
+				m_active[i / 64] |= uint64_t(1) << (i % 64);
+				m_list[i] = i;
+			}
+		}
+
+		/**
+		 * @brief Number of blocks
+		 */
+		unsigned int blocks() const
+		{
+			return m_blocks;
+		}
+
+		/**
+		 * @brief Checks whether a block is active in the current time step
+		 */
+		bool active(unsigned int block) const
+		{
+			return (m_active[block / 64] >> (block % 64)) & 1;
+		}
+
+		/**
+		 * @brief The indices of the blocks that are active in the current time step
+		 */
+		const std::vector<unsigned int>& list() const
+		{
+			return m_list;
+		}
+
+		/**
+		 * @brief Reports whether the cells of an active block changed
+		 *
+		 * Different blocks may be reported by different threads.
+		 */
+		void setChanged(unsigned int block, bool changed)
+		{
+			m_changed[block] = changed;
+		}
+
+		/**
+		 * @brief Starts the next time step, activates the changed blocks and their neighbours
+		 */
+		void update()
+		{
+			const unsigned int words = m_active.size();
+
+			std::vector<uint64_t> changed(words);
+			for (unsigned int i = 0; i < m_blocks; i++)
+				if (m_changed[i])
+					changed[i / 64] |= uint64_t(1) << (i % 64);
+
+			// Wake the neighbours, including the ones in the next and previous word
+			for (unsigned int w = 0; w < words; w++)
+			{
+				uint64_t bits = changed[w] | (changed[w] << 1) | (changed[w] >> 1);
+				if (w > 0)
+					bits |= changed[w-1] >> 63;
+				if (w+1 < words)
+					bits |= changed[w+1] << 63;
+				m_active[w] = bits;
+			}
+			if (m_blocks % 64)
+				m_active[words-1] &= (uint64_t(1) << (m_blocks % 64)) - 1;
+
+			m_list.clear();
+			for (unsigned int w = 0; w < words; w++)
+			{
+				for (uint64_t bits = m_active[w]; bits; bits &= bits-1)
+					m_list.push_back(w*64 + __builtin_ctzll(bits));
+			}
+
+			std::fill(m_changed.begin(), m_changed.end(), 0);
+		}
+
+	};
+
+}
+
+#endif /* TOOLS_ACTIVEBLOCKS_H_ */
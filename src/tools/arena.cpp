@@ -0,0 +1,65 @@
+/**
+ * @file arena.cpp
+ * @brief Implementation of tools::Arena
+ */
+
+#include <cstdlib>
+#include <new>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+#include "arena.hpp"
+#include "logger.hpp"
+
+tools::Arena::Arena(size_t size, bool hugePages)
+	: m_data(0L), m_size(size), m_mapped(false), m_used(0)
+{
+#ifdef __linux__
+	if (hugePages)
+	{
+		// Map one huge page more than needed and cut off the unaligned parts
+		m_size = (size + HUGE_PAGE_SIZE-1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+		const size_t mapped = m_size + HUGE_PAGE_SIZE;
+		void *data = mmap(0L, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (data != MAP_FAILED)
+		{
+			char *begin = static_cast<char*>(data);
+			char *aligned = begin + (HUGE_PAGE_SIZE - reinterpret_cast<size_t>(begin) % HUGE_PAGE_SIZE) % HUGE_PAGE_SIZE;
+			if (aligned > begin)
+				munmap(begin, aligned - begin);
+			if (aligned + m_size < begin + mapped)
+				munmap(aligned + m_size, begin + mapped - (aligned + m_size));
+
+			if (madvise(aligned, m_size, MADV_HUGEPAGE) != 0)
+				tools::Logger::logger.warning("Transparent huge pages are not available");
+
+			m_data = aligned;
+			m_mapped = true;
+			return;
+		}
+
+		tools::Logger::logger.warning("Could not map huge pages, using normal pages");
+		m_size = size;
+	}
+#else
+	if (hugePages)
+		tools::Logger::logger.warning("Transparent huge pages are only available on Linux");
+#endif
+
+	void *data;
+	if (posix_memalign(&data, ALIGNMENT, m_size) != 0)
+		throw std::bad_alloc();
+	m_data = static_cast<char*>(data);
+}
+
+tools::Arena::~Arena()
+{
+#ifdef __linux__
+	if (m_mapped)
+	{
+		munmap(m_data, m_size);
+		return;
+	}
+#endif
+	free(m_data);
+}
@@ -0,0 +1,181 @@
+/**
+ * @file arena.hpp
+ * @brief Aligned memory for the arrays of the solver
+ */
+
+#ifndef TOOLS_ARENA_H_
+#define TOOLS_ARENA_H_
+
+#include <cassert>
+#include <cstddef>
+
+namespace tools
+{
+
+	/**
+	 * @brief A single aligned allocation that is split into fields
+	 *
+	 * The memory is aligned to cache lines. With huge pages the arena is mapped
+	 * anonymously, aligned to 2 MiB and marked for transparent huge pages, which
+	 * reduces the TLB misses of the streaming passes over large domains. If the
+	 * kernel does not support them, normal pages are used.
+	 *
+	 * The memory is not initialized, so it is placed by the first thread that
+	 * touches it.
+	 */
+	class Arena
+	{
+
+	public:
+
+		/** @brief Alignment of the arena and of all fields (one cache line, one AVX-512 vector) */
+		static const size_t ALIGNMENT = 64;
+
+		/** @brief Size of a transparent huge page */
+		static const size_t HUGE_PAGE_SIZE = 2*1024*1024;
+
+	private:
+
+		/** @brief The memory */
+		char *m_data;
+
+		/** @brief Size of the memory */
+		size_t m_size;
+
+		/** @brief Whether the memory was mapped (huge pages) or allocated */
+		bool m_mapped;
+
+		/** @brief Bytes used by the fields allocated so far */
+		size_t m_used;
+
+	public:
+
+		/**
+		 * @brief Constructor, allocates the memory
+		 *
+		 * @param size The size in bytes, should include the padding of the fields (see Arena::padded)
+		 * @param hugePages Back the arena with transparent huge pages
+		 */
+		Arena(size_t size, bool hugePages = false);
+
+		/**
+		 * @brief Destructor, frees the memory
+		 */
+		~Arena();
+
+		/**
+		 * @brief Takes the next field from the arena
+		 *
+		 * The element with index offset of the field is aligned, so the interior of a
+		 * domain with offset ghost cells starts at a cache line. Consecutive fields are
+		 * separated by an additional cache line, so equal indices of different fields
+		 * do not map to the same cache set if the size is a power of two.
+		 *
+		 * @param count Number of elements
+		 * @param offset Index of the element that is aligned
+		 *
+		 * @return The field
+		 */
+		template<typename T> T* field(size_t count, size_t offset = 0)
+		{
+			const size_t start = m_used + (ALIGNMENT - (offset*sizeof(T)) % ALIGNMENT) % ALIGNMENT;
+			m_used = (start + count*sizeof(T) + ALIGNMENT-1) / ALIGNMENT * ALIGNMENT + ALIGNMENT;
+			assert(m_used <= m_size);
+			return reinterpret_cast<T*>(m_data + start);
+		}
+
+		/**
+		 * @brief Size of the memory
+		 */
+		size_t size() const
+		{
+			return m_size;
+		}
+
+		/**
+		 * @brief The space a field takes in an arena, including its padding
+		 *
+		 * @param bytes The size of the field
+		 */
+		static size_t padded(size_t bytes)
+		{
+			return (bytes + ALIGNMENT-1) / ALIGNMENT * ALIGNMENT + 2*ALIGNMENT;
+		}
+
+	private:
+
+		/** @brief Arenas own their memory and can not be copied */
+		Arena(const Arena&);
+		/** @brief Arenas own their memory and can not be copied */
+		Arena& operator=(const Arena&);
+
+	};
+
+	/**
+	 * @brief The unknowns h, hu and b of a domain in one arena
+	 *
+	 * Every field has (size+2)*members values, with a ghost cell on each side.
+	 * The first interior value (index members) of every field is aligned.
+	 */
+	template<typename T> class State
+	{
+
+	private:
+
+		/** @brief The memory of all fields */
+		Arena m_arena;
+
+		/** @brief The water heights */
+		T *m_h;
+		/** @brief The momentums */
+		T *m_hu;
+		/** @brief The bathymetries */
+		T *m_b;
+
+	public:
+
+		/**
+		 * @brief Constructor, allocates the fields
+		 *
+		 * @param size Number of cells without the ghost cells
+		 * @param members Number of domains stored next to each other
+		 * @param hugePages Back the fields with transparent huge pages
+		 */
+		State(unsigned int size, unsigned int members = 1, bool hugePages = false)
+			: m_arena(3*Arena::padded((size+2ull)*members*sizeof(T)), hugePages)
+		{
+			const size_t count = (size+2ull)*members;
+			m_h = m_arena.field<T>(count, members);
+			m_hu = m_arena.field<T>(count, members);
+			m_b = m_arena.field<T>(count, members);
+		}
+
+		/**
+		 * @brief The water heights
+		 */
+		T* h()
+		{
+			return m_h;
+		}
+
+		/**
+		 * @brief The momentums
+		 */
+		T* hu()
+		{
+			return m_hu;
+		}
+
+		/**
+		 * @brief The bathymetries
+		 */
+		T* b()
+		{
+			return m_b;
+		}
+
+	};
+
+}
+
+#endif /* TOOLS_ARENA_H_ */
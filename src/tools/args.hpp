@@ -9,9 +9,14 @@
 #include <getopt.h>
 #include <cstdlib>
 #include <iostream>
+#include <limits>
 #include <sstream>
+#include <string>
+#include <utility>
 #include <vector>
 #include "logger.hpp"
+#include "compression.hpp"
+#include "../scenarios/registry.hpp"
 
 /**
  * @brief Collection of miscellaneous helpers
@@ -25,6 +30,20 @@ namespace tools
 	class Args
 	{
 
+	public:
+
+		/** @brief The available output formats */
+		enum Output { VTK, SERIES, CSV, TSV };
+
+		/** @brief The available precisions: float, double or float storage with double computation */
+		enum Precision { SINGLE, DOUBLE, MIXED };
+
+		/** @brief Maximum number of refinement levels of the adaptive grid */
+		static const unsigned int MAX_AMR_LEVELS = 16;
+
+		/** @brief Maximum number of time step levels of the local time stepping */
+		static const unsigned int MAX_LTS_LEVELS = 16;
+
 	private:
 
 		/** @brief Domain size */
@@ -33,6 +52,117 @@ namespace tools
 		/** @brief Number of time steps we want to simulate */
 		unsigned int m_timeSteps;
 
+		/** @brief Do each time step in a single sweep */
+		bool m_fused;
+
+		/** @brief Number of threads */
+		unsigned int m_threads;
+
+		/** @brief The output format */
+		Output m_output;
+
+		/** @brief The floating point precision */
+		Precision m_precision;
+
+		/** @brief Write binary vtk files */
+		bool m_binary;
+
+		/** @brief Approximate the froude numbers of the output */
+		bool m_fastFroude;
+
+		/** @brief Compression of the binary vtk arrays */
+		Compression::Method m_compression;
+
+		/** @brief Compression level, the default of the library if negative */
+		int m_compressionLevel;
+
+		/** @brief Uncompressed size of a compressed block in bytes */
+		unsigned int m_compressionBlock;
+
+		/** @brief Number of buffers for writing in the background */
+		unsigned int m_asyncBuffers;
+
+		/** @brief Write every m_outputSteps time steps */
+		unsigned int m_outputSteps;
+
+		/** @brief Write every m_outputInterval simulated time */
+		double m_outputInterval;
+
+		/** @brief Number of ensemble members (0 = no ensemble) */
+		unsigned int m_members;
+
+		/** @brief Range of the swept scenario parameter */
+		std::pair<double, double> m_sweep;
+
+		/** @brief Whether a sweep range was given */
+		bool m_hasSweep;
+
+		/** @brief Use a separate time step for every ensemble member */
+		bool m_memberTimeSteps;
+
+		/** @brief Maximum refinement level of the adaptive grid (0 = uniform grid) */
+		unsigned int m_amrLevels;
+
+		/** @brief Refinement threshold of the adaptive grid */
+		double m_amrThreshold;
+
+		/** @brief Maximum time step level of the local time stepping (0 = global time steps) */
+		unsigned int m_ltsLevels;
+
+		/** @brief Number of (base) cells in a block of the adaptive grid, the local time stepping or the active blocks */
+		unsigned int m_blockSize;
+
+		/** @brief Only compute the blocks that are not at rest */
+		bool m_activeBlocks;
+
+		/** @brief Blocks with smaller net-updates fall asleep */
+		double m_sleepThreshold;
+
+		/** @brief Save a checkpoint every m_checkpointSteps time steps */
+		unsigned int m_checkpointSteps;
+
+		/** @brief Save a checkpoint every m_checkpointInterval seconds (wall-clock time) */
+		double m_checkpointInterval;
+
+		/** @brief Write the checkpoints in the background */
+		bool m_checkpointAsync;
+
+		/** @brief The checkpoint used for restarting, empty for a new simulation */
+		std::string m_restart;
+
+		/** @brief The JSON file of the profiler, empty if not needed */
+		std::string m_profileJson;
+
+		/** @brief Read the hardware performance counters */
+		bool m_counters;
+
+		/** @brief Back the solver arrays with transparent huge pages */
+		bool m_hugePages;
+
+		/** @brief The scenario */
+		scenarios::Type m_scenario;
+
+		/** @brief The parameters of the scenario, missing ones use the defaults */
+		std::vector<double> m_scenarioParameters;
+
+		/** @brief The profile with the bathymetry and initial values, empty for the default scenario */
+		std::string m_bathymetry;
+
+		/** @brief Length of the domain of a profile */
+		double m_length;
+
+		/** @brief Significant digits of the text output, shortest round-trip representation if negative */
+		int m_digits;
+
+		/** @brief Messages below this level are not logged */
+		Logger::Level m_logLevel;
+
+		/** @brief Minimum wall-clock time between two progress messages */
+		double m_progressInterval;
+
+		/** @brief Regions of cells [first, last) that are written */
+		std::vector<std::pair<unsigned int, unsigned int> > m_regions;
+
 		/** @brief Array of extra option for the scenario */
 		// std::vector<int> m_options;
 
@@ -45,11 +175,51 @@ namespace tools
 		 * @param argv Argument buffer
 		 */
 		Args(int argc, char** argv)
-			: m_size(100), m_timeSteps(500.0)
+			: m_size(100), m_timeSteps(500.0), m_fused(false), m_threads(1), m_output(VTK), m_precision(SINGLE), m_binary(false),
+			  m_fastFroude(false), m_compression(Compression::NONE), m_compressionLevel(-1), m_compressionBlock(32768), m_asyncBuffers(0),
+			  m_outputSteps(0), m_outputInterval(0), m_members(0), m_sweep(0, 0), m_hasSweep(false),
+			  m_memberTimeSteps(false), m_amrLevels(0), m_amrThreshold(.5), m_ltsLevels(0),
+			  m_blockSize(16), m_activeBlocks(false), m_sleepThreshold(0),
+			  m_checkpointSteps(0), m_checkpointInterval(0), m_checkpointAsync(false),
+			  m_counters(false), m_hugePages(false), m_scenario(scenarios::BATHTUB), m_length(1000), m_digits(-1),
+			  m_logLevel(Logger::INFO), m_progressInterval(0)
 		{
 			const struct option longOptions[] = {
 				{"size", required_argument, 0, 's'},
 				{"time", required_argument, 0, 't'},
+				{"fused", no_argument, 0, 'f'},
+				{"threads", required_argument, 0, 'n'},
+				{"writer", required_argument, 0, 'w'},
+				{"precision", required_argument, 0, 'p'},
+				{"binary", no_argument, 0, 'b'},
+				{"compress", required_argument, 0, 'z'},
+				{"fast-froude", no_argument, 0, 'F'},
+				{"async", required_argument, 0, 'a'},
+				{"output-steps", required_argument, 0, 'o'},
+				{"output-interval", required_argument, 0, 'i'},
+				{"region", required_argument, 0, 'r'},
+				{"ensemble", required_argument, 0, 'e'},
+				{"sweep", required_argument, 0, 'S'},
+				{"member-time-steps", no_argument, 0, 'm'},
+				{"amr", required_argument, 0, 'A'},
+				{"amr-threshold", required_argument, 0, 'T'},
+				{"lts", required_argument, 0, 'L'},
+				{"block", required_argument, 0, 'B'},
+				{"active-blocks", no_argument, 0, 'q'},
+				{"sleep-threshold", required_argument, 0, 'Q'},
+				{"checkpoint-steps", required_argument, 0, 'c'},
+				{"checkpoint-interval", required_argument, 0, 'C'},
+				{"checkpoint-async", no_argument, 0, 'k'},
+				{"restart", required_argument, 0, 'R'},
+				{"profile-json", required_argument, 0, 'P'},
+				{"counters", no_argument, 0, 'H'},
+				{"huge-pages", no_argument, 0, 'g'},
+				{"scenario", required_argument, 0, 'x'},
+				{"bathymetry", required_argument, 0, 'y'},
+				{"length", required_argument, 0, 'l'},
+				{"log-level", required_argument, 0, 'v'},
+				{"progress", required_argument, 0, 'd'},
+				{"digits", required_argument, 0, 'D'},
 				//{"options", optional_argument, 0, 'o'},
 				{"help", no_argument, 0, 'h'},
 				{0, 0, 0, 0}
@@ -59,7 +229,9 @@ namespace tools
 			int optionIndex = 0;
 			int parseIndex = 0;
 			std::istringstream ss;
-			while ((c = getopt_long(argc, argv, "s:t:h", longOptions, &optionIndex)) >= 0) //"s:t:o:h"
+			// Echo of the domain size and the time steps, printed after the output is selected
+			std::ostringstream echo;
+			while ((c = getopt_long(argc, argv, "s:t:fn:w:p:bFa:o:i:r:e:S:mA:T:L:B:qQ:c:C:kR:P:Hgx:y:l:v:d:D:z:h", longOptions, &optionIndex)) >= 0) //"s:t:o:h"
 			{
 				switch (c) 
 				{
@@ -70,13 +242,245 @@ namespace tools
 					ss.clear();
 					ss.str(optarg);
 					ss >> m_size;
-					std::cout << m_size << std::endl;
+					echo << m_size << '\n';
 					break;
 				case 't':
 					ss.clear();
 					ss.str(optarg);
 					ss >> m_timeSteps;
-					std::cout << m_timeSteps << std::endl;
+					echo << m_timeSteps << '\n';
+					break;
+				case 'f':
+					m_fused = true;
+					break;
+				case 'n':
+					ss.clear();
+					ss.str(optarg);
+					ss >> m_threads;
+					break;
+				case 'w':
+					if (std::string(optarg) == "vtk")
+						m_output = VTK;
+					else if (std::string(optarg) == "series")
+						m_output = SERIES;
+					else if (std::string(optarg) == "csv")
+						m_output = CSV;
+					else if (std::string(optarg) == "tsv")
+						m_output = TSV;
+					else
+						tools::Logger::logger.error("Unknown writer");
+					break;
+				case 'p':
+					if (std::string(optarg) == "single")
+						m_precision = SINGLE;
+					else if (std::string(optarg) == "double")
+						m_precision = DOUBLE;
+					else if (std::string(optarg) == "mixed")
+						m_precision = MIXED;
+					else
+						tools::Logger::logger.error("Unknown precision");
+					break;
+				case 'b':
+					m_binary = true;
+					break;
+				case 'F':
+					m_fastFroude = true;
+					break;
+				case 'z':
+					{
+						// METHOD[:LEVEL[:BLOCK]]
+						const std::string compression(optarg);
+						const std::string::size_type colon = compression.find(':');
+						const std::string method = compression.substr(0, colon);
+						if (method == "zlib")
+							m_compression = Compression::ZLIB;
+						else if (method == "lz4")
+							m_compression = Compression::LZ4;
+						else if (method == "none")
+							m_compression = Compression::NONE;
+						else
+							tools::Logger::logger.error("Unknown compression");
+						if (!Compression::available(m_compression))
+							tools::Logger::logger.error("The compression is not available (build with zlib=1 or lz4=1)");
+
+						if (colon != std::string::npos)
+						{
+							ss.clear();
+							ss.str(compression.substr(colon+1));
+							char separator = 0;
+							if (!(ss >> m_compressionLevel) || ((ss >> separator) && (separator != ':' || !(ss >> m_compressionBlock)))
+									|| !ss.eof() || m_compressionBlock == 0)
+								tools::Logger::logger.error("Compression has to be given as METHOD:LEVEL:BLOCK");
+						}
+						// Compressed arrays are binary
+						if (m_compression != Compression::NONE)
+							m_binary = true;
+					}
+					break;
+				case 'a':
+					ss.clear();
+					ss.str(optarg);
+					ss >> m_asyncBuffers;
+					break;
+				case 'o':
+					ss.clear();
+					ss.str(optarg);
+					ss >> m_outputSteps;
+					break;
+				case 'i':
+					ss.clear();
+					ss.str(optarg);
+					ss >> m_outputInterval;
+					break;
+				case 'r':
+					{
+						std::pair<unsigned int, unsigned int> region;
+						char separator = 0;
+						ss.clear();
+						ss.str(optarg);
+						ss >> region.first >> separator >> region.second;
+						if (ss.fail() || separator != ':' || region.first >= region.second)
+							tools::Logger::logger.error("Regions have to be given as FIRST:LAST");
+						m_regions.push_back(region);
+					}
+					break;
+				case 'e':
+					ss.clear();
+					ss.str(optarg);
+					ss >> m_members;
+					break;
+				case 'S':
+					{
+						char separator = 0;
+						ss.clear();
+						ss.str(optarg);
+						ss >> m_sweep.first >> separator >> m_sweep.second;
+						if (ss.fail() || separator != ':')
+							tools::Logger::logger.error("Sweeps have to be given as MIN:MAX");
+						m_hasSweep = true;
+					}
+					break;
+				case 'm':
+					m_memberTimeSteps = true;
+					break;
+				case 'A':
+					ss.clear();
+					ss.str(optarg);
+					ss >> m_amrLevels;
+					if (m_amrLevels > MAX_AMR_LEVELS)
+						tools::Logger::logger.error(("The adaptive grid has at most "
+							+ std::to_string(MAX_AMR_LEVELS) + " refinement levels").c_str());
+					break;
+				case 'T':
+					ss.clear();
+					ss.str(optarg);
+					ss >> m_amrThreshold;
+					break;
+				case 'L':
+					ss.clear();
+					ss.str(optarg);
+					ss >> m_ltsLevels;
+					if (m_ltsLevels > MAX_LTS_LEVELS)
+						tools::Logger::logger.error(("The local time stepping has at most "
+							+ std::to_string(MAX_LTS_LEVELS) + " time step levels").c_str());
+					break;
+				case 'B':
+					ss.clear();
+					ss.str(optarg);
+					ss >> m_blockSize;
+					if (m_blockSize == 0)
+						tools::Logger::logger.error("The block size has to be positive");
+					break;
+				case 'q':
+					m_activeBlocks = true;
+					break;
+				case 'Q':
+					ss.clear();
+					ss.str(optarg);
+					ss >> m_sleepThreshold;
+					break;
+				case 'c':
+					ss.clear();
+					ss.str(optarg);
+					ss >> m_checkpointSteps;
+					break;
+				case 'C':
+					ss.clear();
+					ss.str(optarg);
+					ss >> m_checkpointInterval;
+					break;
+				case 'k':
+					m_checkpointAsync = true;
+					break;
+				case 'R':
+					m_restart = optarg;
+					break;
+				case 'P':
+					m_profileJson = optarg;
+					break;
+				case 'H':
+					m_counters = true;
+					break;
+				case 'g':
+					m_hugePages = true;
+					break;
+				case 'x':
+					{
+						const std::string scenario(optarg);
+						const std::string::size_type colon = scenario.find(':');
+						if (!scenarios::find(scenario.substr(0, colon), m_scenario))
+							tools::Logger::logger.error("Unknown scenario");
+
+						m_scenarioParameters.clear();
+						if (colon != std::string::npos)
+						{
+							ss.clear();
+							ss.str(scenario.substr(colon+1));
+							double parameter;
+							char separator = ':';
+							while (separator == ':' && ss >> parameter)
+							{
+								m_scenarioParameters.push_back(parameter);
+								separator = 0;
+								ss >> separator;
+							}
+							// A separator has to be followed by a value, so empty parameters are rejected
+							if (!ss.eof() || m_scenarioParameters.empty() || separator == ':')
+								tools::Logger::logger.error("Scenario parameters have to be given as NAME:P1:P2");
+						}
+						if (m_scenarioParameters.size() > scenarios::describe(m_scenario).parameterCount)
+							tools::Logger::logger.error("Too many parameters for the scenario");
+					}
+					break;
+				case 'y':
+					m_bathymetry = optarg;
+					break;
+				case 'l':
+					ss.clear();
+					ss.str(optarg);
+					ss >> m_length;
+					break;
+				case 'v':
+					if (std::string(optarg) == "debug")
+						m_logLevel = Logger::DEBUGGING;
+					else if (std::string(optarg) == "info")
+						m_logLevel = Logger::INFO;
+					else if (std::string(optarg) == "warning")
+						m_logLevel = Logger::WARNING;
+					else if (std::string(optarg) == "error")
+						m_logLevel = Logger::ERROR;
+					else
+						tools::Logger::logger.error("Unknown log level");
+					break;
+				case 'd':
+					ss.clear();
+					ss.str(optarg);
+					ss >> m_progressInterval;
+					break;
+				case 'D':
+					ss.clear();
+					ss.str(optarg);
+					ss >> m_digits;
 					break;
 				/*case 'o':
 					parseIndex = optionIndex - 1;
@@ -109,6 +513,15 @@ namespace tools
 					break;
 				}
 			}
+
+			// The cells of a block on the finest level have to be countable
+			if (((unsigned long long) m_blockSize << m_amrLevels) > std::numeric_limits<unsigned int>::max())
+				tools::Logger::logger.error("The blocks on the finest level are too large, use fewer levels or smaller blocks");
+
+			// The text writers use stdout, all messages go to stderr
+			if (m_output == CSV || m_output == TSV)
+				tools::Logger::logger.setOutputStream(std::cerr);
+			tools::Logger::logger << echo.str();
 		}
 
 		/**
@@ -127,6 +540,302 @@ namespace tools
 			return m_timeSteps;
 		}
 
+		/**
+		 * @brief Whether each time step is done in a single sweep
+		 */
+		bool fused()
+		{
+			return m_fused;
+		}
+
+		/**
+		 * @brief The number of threads
+		 */
+		unsigned int threads()
+		{
+			return m_threads;
+		}
+
+		/**
+		 * @brief The output format
+		 */
+		Output output()
+		{
+			return m_output;
+		}
+
+		/**
+		 * @brief The floating point precision
+		 */
+		Precision precision()
+		{
+			return m_precision;
+		}
+
+		/**
+		 * @brief Whether binary vtk files should be written
+		 */
+		bool binary()
+		{
+			return m_binary;
+		}
+
+		/**
+		 * @brief Whether the froude numbers of the output are approximated with the reciprocal square root
+		 */
+		bool fastFroude()
+		{
+			return m_fastFroude;
+		}
+
+		/**
+		 * @brief Compression of the binary vtk arrays
+		 */
+		Compression::Method compression()
+		{
+			return m_compression;
+		}
+
+		/**
+		 * @brief Compression level, the default of the library if negative
+		 */
+		int compressionLevel()
+		{
+			return m_compressionLevel;
+		}
+
+		/**
+		 * @brief Uncompressed size of a compressed block in bytes
+		 */
+		unsigned int compressionBlock()
+		{
+			return m_compressionBlock;
+		}
+
+		/**
+		 * @brief Number of buffers for writing in the background (0 = synchronous)
+		 */
+		unsigned int asyncBuffers()
+		{
+			return m_asyncBuffers;
+		}
+
+		/**
+		 * @brief Write every outputSteps() time steps (0 = disabled)
+		 */
+		unsigned int outputSteps()
+		{
+			return m_outputSteps;
+		}
+
+		/**
+		 * @brief Write every outputInterval() simulated time (0 = disabled)
+		 */
+		double outputInterval()
+		{
+			return m_outputInterval;
+		}
+
+		/**
+		 * @brief The regions of cells [first, last) that are written, the whole domain if empty
+		 */
+		const std::vector<std::pair<unsigned int, unsigned int> >& regions()
+		{
+			return m_regions;
+		}
+
+		/**
+		 * @brief The number of ensemble members (0 = no ensemble)
+		 */
+		unsigned int members()
+		{
+			return m_members;
+		}
+
+		/**
+		 * @brief Whether the scenario parameter is swept over the ensemble members
+		 */
+		bool hasSweep()
+		{
+			return m_hasSweep;
+		}
+
+		/**
+		 * @brief The range of the swept scenario parameter
+		 */
+		std::pair<double, double> sweep()
+		{
+			return m_sweep;
+		}
+
+		/**
+		 * @brief Whether every ensemble member uses its own time step
+		 */
+		bool memberTimeSteps()
+		{
+			return m_memberTimeSteps;
+		}
+
+		/**
+		 * @brief The maximum refinement level of the adaptive grid (0 = uniform grid)
+		 */
+		unsigned int amrLevels()
+		{
+			return m_amrLevels;
+		}
+
+		/**
+		 * @brief The refinement threshold of the adaptive grid
+		 */
+		double amrThreshold()
+		{
+			return m_amrThreshold;
+		}
+
+		/**
+		 * @brief The maximum time step level of the local time stepping (0 = global time steps)
+		 */
+		unsigned int ltsLevels()
+		{
+			return m_ltsLevels;
+		}
+
+		/**
+		 * @brief The number of (base) cells in a block of the adaptive grid, the local time stepping or the active blocks
+		 */
+		unsigned int blockSize()
+		{
+			return m_blockSize;
+		}
+
+		/**
+		 * @brief Whether only the blocks that are not at rest are computed
+		 */
+		bool activeBlocks()
+		{
+			return m_activeBlocks;
+		}
+
+		/**
+		 * @brief Blocks with smaller net-updates fall asleep (0 = only blocks without any update)
+		 */
+		double sleepThreshold()
+		{
+			return m_sleepThreshold;
+		}
+
+		/**
+		 * @brief Save a checkpoint every checkpointSteps() time steps (0 = disabled)
+		 */
+		unsigned int checkpointSteps()
+		{
+			return m_checkpointSteps;
+		}
+
+		/**
+		 * @brief Save a checkpoint every checkpointInterval() seconds of wall-clock time (0 = disabled)
+		 */
+		double checkpointInterval()
+		{
+			return m_checkpointInterval;
+		}
+
+		/**
+		 * @brief Whether the checkpoints are written in the background
+		 */
+		bool checkpointAsync()
+		{
+			return m_checkpointAsync;
+		}
+
+		/**
+		 * @brief The checkpoint used for restarting, empty for a new simulation
+		 */
+		const std::string& restart()
+		{
+			return m_restart;
+		}
+
+		/**
+		 * @brief The JSON file of the profiler, empty if not needed
+		 */
+		const std::string& profileJson()
+		{
+			return m_profileJson;
+		}
+
+		/**
+		 * @brief Whether the hardware performance counters are read
+		 */
+		bool counters()
+		{
+			return m_counters;
+		}
+
+		/**
+		 * @brief Whether the solver arrays are backed by transparent huge pages
+		 */
+		bool hugePages()
+		{
+			return m_hugePages;
+		}
+
+		/**
+		 * @brief The scenario
+		 */
+		scenarios::Type scenario()
+		{
+			return m_scenario;
+		}
+
+		/**
+		 * @brief The parameters of the scenario, missing ones use the defaults
+		 */
+		const std::vector<double>& scenarioParameters()
+		{
+			return m_scenarioParameters;
+		}
+
+		/**
+		 * @brief The profile with the bathymetry and initial values, empty for the default scenario
+		 */
+		const std::string& bathymetry()
+		{
+			return m_bathymetry;
+		}
+
+		/**
+		 * @brief The length of the domain of a profile
+		 */
+		double length()
+		{
+			return m_length;
+		}
+
+		/**
+		 * @brief Significant digits of the text output, the shortest representation that round-trips if negative
+		 */
+		int digits()
+		{
+			return m_digits;
+		}
+
+		/**
+		 * @brief The lowest level of messages that are logged
+		 */
+		Logger::Level logLevel()
+		{
+			return m_logLevel;
+		}
+
+		/**
+		 * @brief Minimum wall-clock time in seconds between two progress messages
+		 */
+		double progressInterval()
+		{
+			return m_progressInterval;
+		}
+
 		/* std::vector<int> options()
 		{
 			return m_options;
@@ -144,6 +853,57 @@ namespace tools
 			out << "Usage: SWE1D [OPTIONS...]" << std::endl
 				<< "  -s, --size=SIZE              domain size" << std::endl
 				<< "  -t, --time=TIME              number of simulated time steps" << std::endl
+				<< "  -f, --fused                  do each time step in a single sweep" << std::endl
+				<< "  -n, --threads=NUM            number of threads" << std::endl
+				<< "  -w, --writer=WRITER          output format: vtk (default), series (single file)," << std::endl
+				<< "                               csv or tsv (text on stdout, messages go to stderr)" << std::endl
+				<< "  -p, --precision=PRECISION    single (default), double or mixed (single storage, double computation)" << std::endl
+				<< "  -b, --binary                 write binary vtk files" << std::endl
+				<< "  -z, --compress=METHOD[:LEVEL[:BLOCK]]" << std::endl
+				<< "                               compress the binary vtk arrays with zlib or lz4 (implies -b)," << std::endl
+				<< "                               LEVEL 1-9, BLOCK bytes per block (32768)" << std::endl
+				<< "  -F, --fast-froude            approximate the froude numbers of the binary vtk, series and" << std::endl
+				<< "                               csv/tsv output with the reciprocal square root (a few ulp)" << std::endl
+				<< "  -a, --async=BUFFERS          write in the background using BUFFERS buffers" << std::endl
+				<< "  -o, --output-steps=N         write every N time steps" << std::endl
+				<< "  -i, --output-interval=DT     write every DT simulated time" << std::endl
+				<< "  -r, --region=FIRST:LAST      only write cells FIRST to LAST-1 (can be repeated)" << std::endl
+				<< "  -e, --ensemble=K             simulate K members together, each member is written separately" << std::endl
+				<< "  -S, --sweep=MIN:MAX          vary the first scenario parameter linearly over the members" << std::endl
+				<< "  -m, --member-time-steps      every member uses its own time step" << std::endl
+				<< "  -A, --amr=LEVELS             refine blocks with steep gradients up to LEVELS (at most 16) times," << std::endl
+				<< "                               the domain grows to a multiple of the block size" << std::endl
+				<< "  -T, --amr-threshold=JUMP     refine where the surface or momentum jumps by more than JUMP (0.5)" << std::endl
+				<< "  -L, --lts=LEVELS             local time steps of up to 2^LEVELS times the global time step," << std::endl
+				<< "                               LEVELS is at most 16, -t then counts macro time steps" << std::endl
+				<< "                               of up to 2^LEVELS global time steps" << std::endl
+				<< "  -B, --block=CELLS            cells per block for -A, -L and -q (16)" << std::endl
+				<< "  -q, --active-blocks          only compute blocks that are not at rest" << std::endl
+				<< "  -Q, --sleep-threshold=EPS    blocks with net-updates up to EPS fall asleep (0)" << std::endl
+				<< "  -c, --checkpoint-steps=N     save a checkpoint (swe1d.checkpoint) every N time steps" << std::endl
+				<< "  -C, --checkpoint-interval=S  save a checkpoint every S seconds of wall-clock time" << std::endl
+				<< "  -k, --checkpoint-async       save the checkpoints in the background" << std::endl
+				<< "  -R, --restart=FILE           continue the simulation from a checkpoint" << std::endl
+				<< "  -P, --profile-json=FILE      write the phase timers to FILE (build with profile=1)" << std::endl
+				<< "  -H, --counters               report hardware counters of the flux computation and the update" << std::endl
+				<< "  -g, --huge-pages             back the solver arrays with transparent huge pages" << std::endl
+				<< "  -x, --scenario=NAME[:P1:P2]  the scenario and its parameters (bathtub)" << std::endl;
+			for (unsigned int i = 0; i < scenarios::TYPES; i++)
+			{
+				const scenarios::Description &description = scenarios::describe(static_cast<scenarios::Type>(i));
+				out << "                                 " << description.name;
+				if (description.parameterCount > 0)
+					out << ": " << description.parameters;
+				out << std::endl;
+			}
+			out << "  -y, --bathymetry=FILE        read bathymetry, surface level and momentum from FILE" << std::endl
+				<< "                               (*.f32/*.f64: raw binary triples, otherwise text columns)" << std::endl
+				<< "  -l, --length=LENGTH          length of the domain of the profile (1000)" << std::endl
+				<< "  -v, --log-level=LEVEL        debug, info (default), warning or error" << std::endl
+				<< "                               (debug messages require a build with debug=1)" << std::endl
+				<< "  -D, --digits=N               significant digits of csv/tsv values (shortest round-trip)" << std::endl
+				<< "  -d, --progress=SECONDS       report the time steps at most every SECONDS of" << std::endl
+				<< "                               wall-clock time (0 = every step)" << std::endl
 				//<< "  -o, --options=OP1 OP2 ...    optional arguments for the scenario" << std::endl
 				<< "  -h, --help                   this help message" << std::endl;
 		}
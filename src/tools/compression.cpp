@@ -0,0 +1,111 @@
+/**
+ * @file compression.cpp
+ * @brief Implementation of tools::Compression
+ */
+
+#include <cstring>
+#ifdef USE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
+#include "compression.hpp"
+#include "logger.hpp"
+
+bool tools::Compression::available(Method method)
+{
+	switch (method)
+	{
+	case ZLIB:
+#ifdef USE_ZLIB
+		return true;
+#else
+		return false;
+#endif
+	case LZ4:
+#ifdef USE_LZ4
+		return true;
+#else
+		return false;
+#endif
+	default:
+		return true;
+	}
+}
+
+const char* tools::Compression::name(Method method)
+{
+	switch (method)
+	{
+	case ZLIB:
+		return "zlib";
+	case LZ4:
+		return "lz4";
+	default:
+		return "none";
+	}
+}
+
+const char* tools::Compression::vtkCompressor(Method method)
+{
+	switch (method)
+	{
+	case ZLIB:
+		return "vtkZLibDataCompressor";
+	case LZ4:
+		return "vtkLZ4DataCompressor";
+	default:
+		return "";
+	}
+}
+
+size_t tools::Compression::bound(Method method, size_t bytes)
+{
+	switch (method)
+	{
+#ifdef USE_ZLIB
+	case ZLIB:
+		return compressBound(bytes);
+#endif
+#ifdef USE_LZ4
+	case LZ4:
+		return LZ4_compressBound(bytes);
+#endif
+	default:
+		return bytes;
+	}
+}
+
+size_t tools::Compression::compress(Method method, int level, const char *in, size_t bytes, char *out)
+{
+	switch (method)
+	{
+#ifdef USE_ZLIB
+	case ZLIB:
+	{
+		uLongf compressed = compressBound(bytes);
+		if (compress2(reinterpret_cast<Bytef*>(out), &compressed, reinterpret_cast<const Bytef*>(in), bytes,
+				level < 0 ? Z_DEFAULT_COMPRESSION : level) != Z_OK)
+			tools::Logger::logger.error("zlib compression failed");
+		return compressed;
+	}
+#endif
+#ifdef USE_LZ4
+	case LZ4:
+	{
+		// Like vtkLZ4DataCompressor, higher levels use less acceleration
+		const int acceleration = level < 0 ? 1 : (level < 9 ? 10 - level : 1);
+		const int compressed = LZ4_compress_fast(in, out, bytes, LZ4_compressBound(bytes), acceleration);
+		if (compressed <= 0)
+			tools::Logger::logger.error("LZ4 compression failed");
+		return compressed;
+	}
+#endif
+	default:
+		// Without a compression library, the level has no meaning
+		(void) level;
+		std::memcpy(out, in, bytes);
+		return bytes;
+	}
+}
@@ -0,0 +1,69 @@
+/**
+ * @file compression.hpp
+ * @brief Block compression of binary output arrays
+ */
+
+#ifndef TOOLS_COMPRESSION_H_
+#define TOOLS_COMPRESSION_H_
+
+#include <cstddef>
+
+namespace tools
+{
+
+	/**
+	 * @brief Compresses blocks with zlib (scons zlib=1) or LZ4 (scons lz4=1)
+	 *
+	 * The blocks are independent of each other, as in the compressed data arrays
+	 * of VTK, so several threads can compress the blocks of an array. Methods that
+	 * are not compiled in are not available.
+	 */
+	class Compression
+	{
+
+	public:
+
+		/** @brief The compression methods */
+		enum Method { NONE, ZLIB, LZ4 };
+
+		/**
+		 * @brief Whether a method is compiled in
+		 */
+		static bool available(Method method);
+
+		/**
+		 * @brief The name of a method on the command line
+		 */
+		static const char* name(Method method);
+
+		/**
+		 * @brief The VTK class that decompresses the method
+		 */
+		static const char* vtkCompressor(Method method);
+
+		/**
+		 * @brief Maximum number of bytes of a compressed block
+		 *
+		 * @param method The compression method
+		 * @param bytes The size of the uncompressed block
+		 */
+		static size_t bound(Method method, size_t bytes);
+
+		/**
+		 * @brief Compresses a block
+		 *
+		 * @param method The compression method
+		 * @param level The compression level (1-9), the default of the library if negative
+		 * @param in The uncompressed block
+		 * @param bytes The size of the uncompressed block
+		 * @param[out] out The compressed block, bound(method, bytes) bytes are available
+		 *
+		 * @return The size of the compressed block
+		 */
+		static size_t compress(Method method, int level, const char *in, size_t bytes, char *out);
+
+	};
+
+}
+
+#endif /* TOOLS_COMPRESSION_H_ */
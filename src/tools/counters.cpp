@@ -0,0 +1,267 @@
+/**
+ * @file counters.cpp
+ * @brief Implementation of tools::PerfCounters and tools::PhaseCounters
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <string>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include "counters.hpp"
+#include "threads.hpp"
+
+namespace
+{
+
+	/**
+	 * @brief Checks whether the floating point events of Intel CPUs can be used
+	 */
+	bool isIntel()
+	{
+		std::ifstream cpuinfo("/proc/cpuinfo");
+		std::string line;
+		while (std::getline(cpuinfo, line))
+		{
+			if (line.compare(0, 9, "vendor_id") == 0)
+				return line.find("GenuineIntel") != std::string::npos;
+		}
+		return false;
+	}
+
+	/**
+	 * @brief Current time in seconds
+	 */
+	double now()
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+}
+
+tools::PerfCounters::PerfCounters(unsigned int threads)
+	: m_fds(EVENTS * std::max(threads, 1u), -1)
+{
+	#pragma omp parallel num_threads(std::max(threads, 1u))
+	{
+#ifdef _OPENMP
+		open(&m_fds[EVENTS*omp_get_thread_num()]);
+#else
+		open(&m_fds[0]);
+#endif
+	}
+
+	for (unsigned int e = 0; e < EVENTS; e++)
+	{
+		m_available[e] = true;
+		for (unsigned int i = e; i < m_fds.size(); i += EVENTS)
+			m_available[e] = m_available[e] && m_fds[i] >= 0;
+	}
+}
+
+tools::PerfCounters::~PerfCounters()
+{
+#ifdef __linux__
+	for (unsigned int i = 0; i < m_fds.size(); i++)
+		if (m_fds[i] >= 0)
+			close(m_fds[i]);
+#endif
+}
+
+bool tools::PerfCounters::available() const
+{
+	for (unsigned int e = 0; e < EVENTS; e++)
+		if (m_available[e])
+			return true;
+	return false;
+}
+
+void tools::PerfCounters::read(Values &values) const
+{
+	std::memset(&values, 0, sizeof(values));
+
+#ifdef __linux__
+	for (unsigned int i = 0; i < m_fds.size(); i++)
+	{
+		const unsigned int e = i % EVENTS;
+		if (!m_available[e])
+			continue;
+
+		// Value, time enabled, time running
+		uint64_t data[3];
+		if (::read(m_fds[i], data, sizeof(data)) != sizeof(data) || data[2] == 0)
+			continue;
+
+		// Scale multiplexed counters
+		values.count[e] += data[1] == data[2] ? data[0] : (double) data[0] * data[1] / data[2];
+	}
+#endif
+}
+
+double tools::PerfCounters::flops(const Values &values, unsigned int scalarSize)
+{
+	// Operations per instruction of every vector width
+	return values.count[FP_SCALAR] + values.count[FP_128] * 16 / scalarSize
+		+ values.count[FP_256] * 32 / scalarSize + values.count[FP_512] * 64 / scalarSize;
+}
+
+const char* tools::PerfCounters::name(Event event)
+{
+	switch (event)
+	{
+	case CYCLES:
+		return "cycles";
+	case INSTRUCTIONS:
+		return "instructions";
+	case LLC_MISSES:
+		return "LLC misses";
+	case FP_SCALAR:
+		return "scalar FP";
+	case FP_128:
+		return "128 bit FP";
+	case FP_256:
+		return "256 bit FP";
+	case FP_512:
+		return "512 bit FP";
+	default:
+		return "unknown";
+	}
+}
+
+void tools::PerfCounters::open(int *fds)
+{
+	for (unsigned int e = 0; e < EVENTS; e++)
+		fds[e] = -1;
+
+#ifdef __linux__
+	static const bool intel = isIntel();
+
+	for (unsigned int e = 0; e < EVENTS; e++)
+	{
+		struct perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		switch (e)
+		{
+		case CYCLES:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_CPU_CYCLES;
+			break;
+		case INSTRUCTIONS:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+			break;
+		case LLC_MISSES:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_CACHE_MISSES;
+			break;
+		default:
+			// FP_ARITH_INST_RETIRED (event 0xc7), the umask selects single and double of one width
+			if (!intel)
+				continue;
+			attr.type = PERF_TYPE_RAW;
+			attr.config = 0xc7 | (0x3ull << (8 + 2*(e-FP_SCALAR)));
+			break;
+		}
+
+		// The calling thread on any CPU
+		fds[e] = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+	}
+#endif
+}
+
+tools::PhaseCounters::PhaseCounters(const char *name, const PerfCounters &counters, unsigned int scalarSize)
+	: m_name(name), m_counters(counters), m_scalarSize(scalarSize), m_seconds(0), m_cells(0), m_startTime(0)
+{
+	std::memset(&m_start, 0, sizeof(m_start));
+	std::memset(&m_total, 0, sizeof(m_total));
+}
+
+void tools::PhaseCounters::start()
+{
+	m_counters.read(m_start);
+	m_startTime = now();
+}
+
+void tools::PhaseCounters::stop(double cells)
+{
+	const double time = now();
+
+	PerfCounters::Values values;
+	m_counters.read(values);
+	for (unsigned int e = 0; e < PerfCounters::EVENTS; e++)
+		m_total.count[e] += values.count[e] - m_start.count[e];
+
+	m_seconds += time - m_startTime;
+	m_cells += cells;
+}
+
+void tools::PhaseCounters::report(std::ostream &out, const Roofline &roofline) const
+{
+	out << m_name << ": " << m_cells / m_seconds * 1e-6 << " MCells/s" << std::endl;
+
+	if (m_counters.available(PerfCounters::CYCLES) && m_counters.available(PerfCounters::INSTRUCTIONS))
+		out << "  IPC                      " << m_total.count[PerfCounters::INSTRUCTIONS] / m_total.count[PerfCounters::CYCLES] << std::endl;
+
+	double bytes = 0;
+	if (m_counters.available(PerfCounters::LLC_MISSES))
+	{
+		// Every miss loads one cache line
+		bytes = m_total.count[PerfCounters::LLC_MISSES] * 64;
+		out << "  LLC misses per cell      " << m_total.count[PerfCounters::LLC_MISSES] / m_cells << std::endl
+			<< "  Bandwidth                " << bytes / m_seconds * 1e-9 << " GB/s ("
+			<< 100 * bytes / m_seconds / roofline.bandwidth << "% of " << roofline.bandwidth * 1e-9 << " GB/s)" << std::endl;
+	}
+
+	double flops = 0;
+	if (m_counters.available(PerfCounters::FP_SCALAR) && m_counters.available(PerfCounters::FP_512))
+	{
+		flops = PerfCounters::flops(m_total, m_scalarSize);
+		out << "  FLOP/s                   " << flops / m_seconds * 1e-9 << " GFLOP/s";
+		if (roofline.flops > 0)
+			out << " (" << 100 * flops / m_seconds / roofline.flops << "% of " << roofline.flops * 1e-9 << " GFLOP/s)";
+		out << std::endl
+			<< "  FLOP per cell            " << flops / m_cells << std::endl;
+	}
+
+	if (bytes > 0 && flops > 0 && roofline.flops > 0)
+	{
+		// The roofline: attainable FLOP/s = min(peak FLOP/s, arithmetic intensity * bandwidth)
+		const double intensity = flops / bytes;
+		const double attainable = std::min(roofline.flops, intensity * roofline.bandwidth);
+		out << "  Arithmetic intensity     " << intensity << " FLOP/byte ("
+			<< (intensity * roofline.bandwidth < roofline.flops ? "bandwidth" : "compute") << "-bound, "
+			<< 100 * flops / m_seconds / attainable << "% of the roofline)" << std::endl;
+	}
+}
+
+double tools::measureBandwidth(unsigned int threads)
+{
+	// Three arrays of 32 MiB, larger than common last level caches
+	const unsigned int size = 1u << 22;
+	std::vector<double> a(size, 1), b(size, 2), c(size, 3);
+
+	double best = 0;
+	for (unsigned int repetition = 0; repetition < 5; repetition++)
+	{
+		const double start = now();
+
+		#pragma omp parallel for num_threads(std::max(threads, 1u)) schedule(static)
+		for (unsigned int i = 0; i < size; i++)
+			a[i] = b[i] + 3 * c[i];
+
+		// Two loads and one store (without the write allocation)
+		best = std::max(best, 3. * size * sizeof(double) / (now() - start));
+	}
+
+	return best;
+}
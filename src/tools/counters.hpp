@@ -0,0 +1,207 @@
+/**
+ * @file counters.hpp
+ * @brief Hardware performance counters
+ */
+
+#ifndef TOOLS_COUNTERS_H_
+#define TOOLS_COUNTERS_H_
+
+#include <iostream>
+#include <vector>
+
+namespace tools
+{
+
+	/**
+	 * @brief Reads hardware performance counters of all threads with perf_event_open (Linux only)
+	 *
+	 * Every thread of the OpenMP team opens its own counters, so the team has to be
+	 * reused by the parallel regions afterwards (which all common OpenMP runtimes do).
+	 * The counters only count user space and run all the time, phases are measured
+	 * by reading them before and after. If the kernel multiplexes the counters, the
+	 * values are scaled by the time the counter was active.
+	 *
+	 * Counters that can not be opened (missing permissions, see perf_event_paranoid,
+	 * virtual machines without a PMU, or other vendors for the floating point events)
+	 * are reported as unavailable, all other counters still work.
+	 */
+	class PerfCounters
+	{
+
+	public:
+
+		/**
+		 * @brief The counted events
+		 *
+		 * The floating point events count instructions by vector width
+		 * (FP_ARITH_INST_RETIRED, Intel only). Each width counts single and
+		 * double precision instructions, so the number of operations per
+		 * instruction depends on the precision of the computation.
+		 */
+		enum Event { CYCLES, INSTRUCTIONS, LLC_MISSES, FP_SCALAR, FP_128, FP_256, FP_512, EVENTS };
+
+		/**
+		 * @brief Values of all events, summed over all threads
+		 */
+		struct Values
+		{
+			/** @brief The count of every event */
+			double count[EVENTS];
+		};
+
+	private:
+
+		/** @brief File descriptors of all threads, EVENTS per thread, -1 if unavailable */
+		std::vector<int> m_fds;
+
+		/** @brief Whether an event could be opened by all threads */
+		bool m_available[EVENTS];
+
+	public:
+
+		/**
+		 * @brief Constructor, opens the counters
+		 *
+		 * @param threads Number of threads in the OpenMP team
+		 */
+		PerfCounters(unsigned int threads);
+
+		/**
+		 * @brief Destructor, closes the counters
+		 */
+		~PerfCounters();
+
+		/**
+		 * @brief Whether an event is counted
+		 */
+		bool available(Event event) const
+		{
+			return m_available[event];
+		}
+
+		/**
+		 * @brief Whether any event is counted
+		 */
+		bool available() const;
+
+		/**
+		 * @brief Reads the current values of all events
+		 *
+		 * @param[out] values The values, 0 for unavailable events
+		 */
+		void read(Values &values) const;
+
+		/**
+		 * @brief The floating point operations of the floating point events
+		 *
+		 * @param values The values
+		 * @param scalarSize The size of a value of the computation (4 or 8 bytes)
+		 */
+		static double flops(const Values &values, unsigned int scalarSize);
+
+		/**
+		 * @brief The name of an event
+		 */
+		static const char* name(Event event);
+
+	private:
+
+		/**
+		 * @brief Opens the counters of the calling thread
+		 *
+		 * @param fds EVENTS file descriptors of the thread
+		 */
+		static void open(int *fds);
+
+	};
+
+	/**
+	 * @brief The measured limits of the machine
+	 */
+	struct Roofline
+	{
+		/** @brief Memory bandwidth in bytes per second */
+		double bandwidth;
+		/** @brief Floating point operations per second, 0 if unknown */
+		double flops;
+	};
+
+	/**
+	 * @brief Accumulates the counters of a phase of the time loop
+	 */
+	class PhaseCounters
+	{
+
+	private:
+
+		/** @brief Name of the phase */
+		const char *m_name;
+
+		/** @brief The counters */
+		const PerfCounters &m_counters;
+
+		/** @brief Size of a value of the computation */
+		unsigned int m_scalarSize;
+
+		/** @brief Values at the start of the current call */
+		PerfCounters::Values m_start;
+
+		/** @brief Accumulated differences of all calls */
+		PerfCounters::Values m_total;
+
+		/** @brief Accumulated time in seconds */
+		double m_seconds;
+
+		/** @brief Accumulated cell updates */
+		double m_cells;
+
+		/** @brief Start of the current call in seconds */
+		double m_startTime;
+
+	public:
+
+		/**
+		 * @brief Constructor
+		 *
+		 * @param name The name of the phase
+		 * @param counters The counters
+		 * @param scalarSize The size of a value of the computation (4 or 8 bytes)
+		 */
+		PhaseCounters(const char *name, const PerfCounters &counters, unsigned int scalarSize);
+
+		/**
+		 * @brief Starts a call of the phase
+		 */
+		void start();
+
+		/**
+		 * @brief Ends a call of the phase
+		 *
+		 * @param cells Number of cells updated by the call
+		 */
+		void stop(double cells);
+
+		/**
+		 * @brief Prints IPC, LLC misses per cell update, FLOP/s, bandwidth and the roofline bound
+		 *
+		 * The memory traffic is estimated as one cache line per LLC miss.
+		 *
+		 * @param out The output stream
+		 * @param roofline The limits of the machine
+		 */
+		void report(std::ostream &out, const Roofline &roofline) const;
+
+	};
+
+	/**
+	 * @brief Measures the memory bandwidth with a triad over arrays much larger than the caches
+	 *
+	 * @param threads Number of threads
+	 *
+	 * @return The best bandwidth in bytes per second
+	 */
+	double measureBandwidth(unsigned int threads);
+
+}
+
+#endif /* TOOLS_COUNTERS_H_ */
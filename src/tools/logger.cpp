@@ -1,8 +1,261 @@
 /**
  * @file logger.cpp
- * @brief Instanciates a singleton tools::Logger::logger
+ * @brief Instanciates a singleton tools::Logger::logger and implements the ring buffer
  */
 
+#include <cstring>
+#include <streambuf>
 #include "logger.hpp"
 
+namespace
+{
+
+	/**
+	 * @brief Collects the characters of a thread and passes every line to the logger
+	 */
+	class LineBuffer : public std::streambuf
+	{
+
+	private:
+
+		/** @brief The level of the messages */
+		tools::Logger::Level m_level;
+
+		/** @brief The current line */
+		char m_line[tools::Logger::RECORD_SIZE];
+
+		/** @brief The beginning of the current line was already passed to the logger */
+		bool m_continued;
+
+	public:
+
+		/**
+		 * @brief Constructor
+		 *
+		 * @param level The level of the messages
+		 */
+		LineBuffer(tools::Logger::Level level)
+			: m_level(level), m_continued(false)
+		{
+			setp(m_line, m_line + tools::Logger::RECORD_SIZE);
+		}
+
+		/**
+		 * @brief Destructor, passes an incomplete line to the logger
+		 */
+		~LineBuffer()
+		{
+			commitLines();
+			if (pptr() > pbase() || m_continued)
+				tools::Logger::logger.push(m_level, pbase(), pptr() - pbase(), m_continued, true);
+		}
+
+	protected:
+
+		/**
+		 * @brief Called when the line does not fit into the buffer
+		 */
+		int_type overflow(int_type c)
+		{
+			commitLines();
+
+			// A line without a newline that fills the whole buffer is split
+			if (pptr() == epptr())
+			{
+				tools::Logger::logger.push(m_level, pbase(), pptr() - pbase(), m_continued, false);
+				m_continued = true;
+				setp(m_line, m_line + tools::Logger::RECORD_SIZE);
+			}
+
+			if (traits_type::eq_int_type(c, traits_type::eof()))
+				return traits_type::not_eof(c);
+
+			*pptr() = traits_type::to_char_type(c);
+			pbump(1);
+			if (traits_type::to_char_type(c) == '\n')
+				commitLines();
+			return c;
+		}
+
+		/**
+		 * @brief Called for strings, passes the lines that end in the string
+		 */
+		std::streamsize xsputn(const char *s, std::streamsize n)
+		{
+			const std::streamsize written = std::streambuf::xsputn(s, n);
+			if (std::memchr(s, '\n', n))
+				commitLines();
+			return written;
+		}
+
+		/**
+		 * @brief Called by std::endl and std::flush
+		 */
+		int sync()
+		{
+			commitLines();
+			return 0;
+		}
+
+	private:
+
+		/**
+		 * @brief Passes all complete lines to the logger and keeps the rest
+		 */
+		void commitLines()
+		{
+			char *begin = pbase();
+			char *end = pptr();
+			for (char *p = begin; p < end; p++)
+			{
+				if (*p == '\n')
+				{
+					tools::Logger::logger.push(m_level, begin, p - begin, m_continued, true);
+					m_continued = false;
+					begin = p+1;
+				}
+			}
+
+			const size_t rest = end - begin;
+			std::memmove(m_line, begin, rest);
+			setp(m_line, m_line + tools::Logger::RECORD_SIZE);
+			pbump(rest);
+		}
+
+	};
+
+}
+
 tools::Logger tools::Logger::logger;
+
+tools::Logger::Logger()
+	: m_output(&std::cout), m_level(INFO), m_records(new Record[CAPACITY]),
+	  m_head(0), m_tail(0), m_flushed(0), m_dropped(0), m_finished(false)
+{
+	for (unsigned long i = 0; i < CAPACITY; i++)
+		m_records[i].sequence.store(i, std::memory_order_relaxed);
+
+	m_thread = std::thread(&Logger::run, this);
+}
+
+tools::Logger::~Logger()
+{
+	m_finished.store(true, std::memory_order_release);
+	m_thread.join();
+	delete [] m_records;
+}
+
+void tools::Logger::flush()
+{
+	const unsigned long head = m_head.load(std::memory_order_acquire);
+	while (m_flushed.load(std::memory_order_acquire) < head)
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+}
+
+std::ostream& tools::Logger::stream(Level level)
+{
+	// Every thread formats its messages in its own buffers
+	static thread_local LineBuffer debugBuffer(DEBUGGING), infoBuffer(INFO), warningBuffer(WARNING);
+	static thread_local std::ostream debugStream(&debugBuffer), infoStream(&infoBuffer), warningStream(&warningBuffer);
+	// Without a buffer, the stream is bad and ignores everything
+	static thread_local std::ostream nullStream(static_cast<std::streambuf*>(0L));
+
+	if (!enabled(level))
+		return nullStream;
+
+	switch (level)
+	{
+	case DEBUGGING:
+		return debugStream;
+	case WARNING:
+		return warningStream;
+	default:
+		return infoStream;
+	}
+}
+
+void tools::Logger::push(Level level, const char *text, unsigned int length, bool continued, bool complete)
+{
+	// Bounded multi-producer queue, every record has a sequence number
+	unsigned long position = m_head.load(std::memory_order_relaxed);
+	Record *record;
+	while (true)
+	{
+		record = &m_records[position & (CAPACITY-1)];
+		const long difference = (long) record->sequence.load(std::memory_order_acquire) - (long) position;
+		if (difference == 0)
+		{
+			if (m_head.compare_exchange_weak(position, position+1, std::memory_order_relaxed))
+				break;
+		}
+		else if (difference < 0)
+		{
+			// The background thread did not print the oldest record yet
+			if (level < WARNING)
+			{
+				m_dropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+
+			// Warnings are never dropped, wait until the background thread printed a record
+			std::this_thread::yield();
+			position = m_head.load(std::memory_order_relaxed);
+		}
+		else
+			position = m_head.load(std::memory_order_relaxed);
+	}
+
+	record->level = level;
+	record->length = length;
+	record->continued = continued;
+	record->complete = complete;
+	std::memcpy(record->text, text, length);
+	record->sequence.store(position+1, std::memory_order_release);
+}
+
+void tools::Logger::run()
+{
+	while (true)
+	{
+		const bool finished = m_finished.load(std::memory_order_acquire);
+
+		std::ostream &output = *m_output.load();
+		if (print(output))
+			continue;
+
+		// The ring buffer is empty
+		const unsigned long dropped = m_dropped.exchange(0);
+		if (dropped > 0)
+			output << "Warning: " << dropped << " log messages were dropped" << '\n';
+		output.flush();
+		m_flushed.store(m_tail.load(std::memory_order_relaxed), std::memory_order_release);
+
+		if (finished)
+			return;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+bool tools::Logger::print(std::ostream &output)
+{
+	const unsigned long position = m_tail.load(std::memory_order_relaxed);
+	Record &record = m_records[position & (CAPACITY-1)];
+	if (record.sequence.load(std::memory_order_acquire) != position+1)
+		return false;
+
+	if (!record.continued)
+	{
+		if (record.level == WARNING)
+			output << "Warning: ";
+		else if (record.level == DEBUGGING)
+			output << "Debug: ";
+	}
+	output.write(record.text, record.length);
+	if (record.complete)
+		output << '\n';
+
+	// The record can be used again in the next round
+	record.sequence.store(position + CAPACITY, std::memory_order_release);
+	m_tail.store(position+1, std::memory_order_relaxed);
+	return true;
+}
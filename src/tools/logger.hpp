@@ -6,52 +6,146 @@
 #ifndef TOOLS_LOGGER_H_
 #define TOOLS_LOGGER_H_
 
+#include <atomic>
+#include <chrono>
 #include <cstdlib>
 #include <iostream>
+#include <string>
+#include <thread>
 
-namespace tools 
+namespace tools
 {
 
 	/**
 	 * @brief Logs messages to an output stream
+	 *
+	 * The calling thread only formats the message into fixed-size records and puts
+	 * them into a lock-free ring buffer. A background thread writes the records to
+	 * the output stream, so the time loop never waits for the terminal or a file.
+	 * A message ends at its newline, std::endl does not flush the output stream.
+	 * If the ring buffer is full, debug and info records are dropped and the number
+	 * of dropped records is reported once the buffer is empty again (at the latest
+	 * when the logger shuts down). Warnings wait for a free record instead.
+	 *
+	 * Messages below the level set with Logger::setLevel are not even formatted.
+	 * Debug messages (LOG_DEBUG) are only compiled in with DEBUG (scons debug=1).
+	 * Errors are written to std::cerr after all pending messages and terminate the program.
 	 */
-	class Logger 
+	class Logger
 	{
 
 		public:
 
-			/** @brief The possible log levels */
-			enum Level { INFO, WARNING, ERROR };
+			/** @brief The possible log levels (not DEBUG, debug builds define it as a macro) */
+			enum Level { DEBUGGING, INFO, WARNING, ERROR };
+
+			/** @brief Number of characters in a record, longer lines are split into several records */
+			static const unsigned int RECORD_SIZE = 232;
+
+			/** @brief Number of records in the ring buffer (a power of two) */
+			static const unsigned long CAPACITY = 4096;
 
 		private:
 
+			/**
+			 * @brief A (part of a) line in the ring buffer
+			 */
+			struct Record
+			{
+				/** @brief Position of the record in the ring buffer, +1 once it is written */
+				std::atomic<unsigned long> sequence;
+				/** @brief The level of the message */
+				Level level;
+				/** @brief Number of characters */
+				unsigned int length;
+				/** @brief The record continues the previous record of the line */
+				bool continued;
+				/** @brief The record ends the line */
+				bool complete;
+				/** @brief The characters (without the newline) */
+				char text[RECORD_SIZE];
+			};
+
 			/** @brief Stream where we print all messages */
-			std::ostream* m_output;
+			std::atomic<std::ostream*> m_output;
+
+			/** @brief Messages below this level are ignored */
+			std::atomic<int> m_level;
+
+			/** @brief The ring buffer */
+			Record *m_records;
+
+			/** @brief The next position that is written */
+			std::atomic<unsigned long> m_head;
+
+			/** @brief The next position that is printed */
+			std::atomic<unsigned long> m_tail;
+
+			/** @brief All positions before this one are printed and flushed */
+			std::atomic<unsigned long> m_flushed;
+
+			/** @brief Number of debug and info records dropped because the ring buffer was full */
+			std::atomic<unsigned long> m_dropped;
+
+			/** @brief Set when the background thread should stop */
+			std::atomic<bool> m_finished;
+
+			/** @brief The background thread that prints the records */
+			std::thread m_thread;
 
 		private:
 
 			/**
-			 * @brief Constructor
+			 * @brief Constructor, starts the background thread
 			 */
-			Logger() : m_output(&std::cout)
-			{
-			}
+			Logger();
 
 		public:
 
+			/**
+			 * @brief Destructor, prints the remaining messages
+			 */
+			~Logger();
+
 			/**
 			 * @brief Sets the output stream
-			 * 
+			 *
+			 * Messages logged before are still printed to the old stream.
+			 *
 			 * @param output The new output stream
 			 */
 			void setOutputStream(std::ostream &output)
 			{
+				flush();
 				m_output = &output;
 			}
 
+			/**
+			 * @brief Ignores all messages below a level
+			 *
+			 * @param level The lowest level that is printed
+			 */
+			void setLevel(Level level)
+			{
+				m_level = level;
+			}
+
+			/**
+			 * @brief Whether messages of a level are printed
+			 */
+			bool enabled(Level level) const
+			{
+				return level >= m_level.load(std::memory_order_relaxed);
+			}
+
+			/**
+			 * @brief Waits until all messages logged so far are printed
+			 */
+			void flush();
+
 			/**
 			 * @brief Logs a message to the output stream
-			 * 
+			 *
 			 * @param message The message
 			 * @param level The logging level
 			 */
@@ -62,13 +156,16 @@ namespace tools
 
 			/**
 			 * @brief Logs a message to the output stream
-			 * 
+			 *
 			 * @param message The message
 			 * @param level The logging level
 			 */
 			void log(const char* message, Level level = INFO)
 			{
 				switch (level) {
+					case DEBUGGING:
+						debug() << message << std::endl;
+						break;
 					case INFO:
 						info(message);
 						break;
@@ -81,9 +178,19 @@ namespace tools
 				}
 			}
 
+			/**
+			 * @brief The stream used for logging debug messages
+			 *
+			 * @return The output stream with a prepended "Debug: "
+			 */
+			std::ostream& debug()
+			{
+				return stream(DEBUGGING);
+			}
+
 			/**
 			 * @brief Logs a message with the info log level
-			 * 
+			 *
 			 * @param message The message
 			 */
 			void info(std::string &message)
@@ -93,27 +200,27 @@ namespace tools
 
 			/**
 			 * @brief Logs a message with the info log level
-			 * 
+			 *
 			 * @param message The message
 			 */
 			void info(const char* message)
 			{
-				*m_output << message << std::endl;
+				stream(INFO) << message << std::endl;
 			}
 
 			/**
 			 * @brief The stream used for logging info messages
-			 * 
+			 *
 			 * @return The unmodified output stream
 			 */
 			std::ostream& info()
 			{
-				return *m_output;
+				return stream(INFO);
 			}
 
 			/**
 			 * @brief Logs a message with the warning log level
-			 * 
+			 *
 			 * @param message The message
 			 */
 			void warning(std::string &message)
@@ -123,27 +230,27 @@ namespace tools
 
 			/**
 			 * @brief Logs a message with the warning log level
-			 * 
+			 *
 			 * @param message The message
 			 */
 			void warning(const char* message)
 			{
-				*m_output << "Warning: " << message << std::endl;
+				stream(WARNING) << message << std::endl;
 			}
 
 			/**
 			 * @brief The stream used for logging warning messages
-			 * 
+			 *
 			 * @return The output stream with a prepended "Warning: "
 			 */
 			std::ostream& warning()
 			{
-				return *m_output << "Warning: ";
+				return stream(WARNING);
 			}
 
 			/**
 			 * @brief Logs a message with the error log level to stderr
-			 * 
+			 *
 			 * @param message The message
 			 */
 			void error(std::string &message)
@@ -153,49 +260,215 @@ namespace tools
 
 			/**
 			 * @brief Logs a message with the error log level to stderr
-			 * 
+			 *
 			 * @param message The message
 			 */
 			void error(const char* message)
 			{
-				// Error messages are always send to std::cerr
+				// Error messages are always send to std::cerr, after the pending messages
+				flush();
 				std::cerr << "Error: " << message << std::endl;
 				exit(1);
 			}
 
 			/**
 			 * @brief Prints arbitrary info messages
-			 * 
+			 *
 			 * Can be used to print arbitrary info messages and does not append std::endl.
-			 * 
+			 *
 			 * @param value The message to log
 			 */
-			template<typename T> Logger& operator<<(T value)
+			template<typename T> Logger& operator<<(const T &value)
 			{
-				*m_output << value;
+				stream(INFO) << value;
 				return *this;
 			}
 
 			/**
 			 * @brief Prints arbitrary info messages
-			 * 
+			 *
 			 * Can be used to print arbitrary info messages and allows to print std::endl
-			 * 
+			 *
 			 * @param func The output stream callback
 			 */
 			Logger& operator<<(std::ostream& (*func)(std::ostream&))
 			{
-				*m_output << func;
+				stream(INFO) << func;
 				return *this;
 			}
 
+			/**
+			 * @brief Puts a record into the ring buffer (called by the streams of the threads)
+			 *
+			 * @param level The level of the message
+			 * @param text The characters
+			 * @param length Number of characters (at most RECORD_SIZE)
+			 * @param continued The record continues the previous record of the line
+			 * @param complete The record ends the line
+			 */
+			void push(Level level, const char *text, unsigned int length, bool continued, bool complete);
+
+		private:
+
+			/**
+			 * @brief The stream of the calling thread for a level
+			 *
+			 * Returns a stream that ignores everything if the level is disabled.
+			 */
+			std::ostream& stream(Level level);
+
+			/**
+			 * @brief Main loop of the background thread
+			 */
+			void run();
+
+			/**
+			 * @brief Prints the next record, if there is one (background thread)
+			 */
+			bool print(std::ostream &output);
+
+			/** @brief The logger owns the background thread and can not be copied */
+			Logger(const Logger&);
+			/** @brief The logger owns the background thread and can not be copied */
+			Logger& operator=(const Logger&);
+
 		public:
-			
+
 			/** @brief Singleton logging instance */
 			static Logger logger;
 
 	};
 
+	/**
+	 * @brief Limits how often a message site logs, see LOG_EVERY
+	 */
+	class RateLimit
+	{
+
+	private:
+
+		/** @brief The minimum time between two messages */
+		std::chrono::steady_clock::duration m_interval;
+
+		/** @brief The earliest time of the next message */
+		std::chrono::steady_clock::time_point m_next;
+
+		/** @brief Number of messages skipped since the last message */
+		unsigned long long m_skipped;
+
+		/** @brief Number of messages skipped before the last message */
+		unsigned long long m_suppressed;
+
+	public:
+
+		/**
+		 * @brief Constructor
+		 *
+		 * @param seconds The minimum wall-clock time between two messages, 0 logs every message
+		 */
+		RateLimit(double seconds)
+			: m_interval(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+				std::chrono::duration<double>(seconds))),
+			  m_skipped(0), m_suppressed(0)
+		{
+		}
+
+		/**
+		 * @brief Whether the next message is logged
+		 */
+		bool allow()
+		{
+			if (m_interval.count() > 0)
+			{
+				const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+				if (now < m_next)
+				{
+					m_skipped++;
+					return false;
+				}
+				m_next = now + m_interval;
+			}
+
+			m_suppressed = m_skipped;
+			m_skipped = 0;
+			return true;
+		}
+
+		/**
+		 * @brief Number of messages skipped before the current message
+		 */
+		unsigned long long suppressed() const
+		{
+			return m_suppressed;
+		}
+
+	};
+
+	/**
+	 * @brief A key/value pair of a structured message, printed as " key=value"
+	 */
+	template<typename T> struct KeyValue
+	{
+		/** @brief The key */
+		const char *key;
+		/** @brief The value */
+		T value;
+	};
+
+	/**
+	 * @brief Creates a key/value pair of a structured message
+	 *
+	 * @param key The key
+	 * @param value The value
+	 */
+	template<typename T> KeyValue<T> kv(const char *key, const T &value)
+	{
+		KeyValue<T> pair = {key, value};
+		return pair;
+	}
+
+	/**
+	 * @brief Prints a key/value pair
+	 */
+	template<typename T> std::ostream& operator<<(std::ostream &out, const KeyValue<T> &pair)
+	{
+		return out << ' ' << pair.key << '=' << pair.value;
+	}
+
+	/**
+	 * @brief Prints the number of messages a rate limit suppressed, nothing if there were none
+	 */
+	inline std::ostream& operator<<(std::ostream &out, const RateLimit &rateLimit)
+	{
+		if (rateLimit.suppressed() > 0)
+			out << kv("suppressed", rateLimit.suppressed());
+		return out;
+	}
+
 }
 
+/**
+ * @brief Logs a debug message, e.g. LOG_DEBUG("dt" << tools::kv("step", i))
+ *
+ * Expands to nothing if DEBUG is not defined.
+ */
+#ifdef DEBUG
+#define LOG_DEBUG(message) do { tools::Logger::logger.debug() << message << std::endl; } while (0)
+#else
+#define LOG_DEBUG(message) do { } while (0)
+#endif
+
+/**
+ * @brief Logs an info message at most once every seconds of wall-clock time
+ *
+ * Every use has its own limit, initialized on the first call. The number of
+ * messages skipped in between is appended.
+ */
+#define LOG_EVERY(seconds, message) \
+	do { \
+		static tools::RateLimit logRateLimit_(seconds); \
+		if (logRateLimit_.allow() && tools::Logger::logger.enabled(tools::Logger::INFO)) \
+			tools::Logger::logger.info() << message << logRateLimit_ << std::endl; \
+	} while (0)
+
 #endif /* TOOLS_LOGGER_H_ */
@@ -0,0 +1,86 @@
+/**
+ * @file mpi.cpp
+ * @brief Implementation of tools::Mpi and tools::Decomposition
+ */
+
+#include "mpi.hpp"
+#include "logger.hpp"
+
+tools::Mpi::Mpi(int &argc, char** &argv)
+{
+#ifdef USE_MPI
+	// Only the main thread calls MPI
+	int provided;
+	MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+#else
+	(void) argc;
+	(void) argv;
+#endif
+}
+
+tools::Mpi::~Mpi()
+{
+#ifdef USE_MPI
+	MPI_Finalize();
+#endif
+}
+
+int tools::Mpi::rank()
+{
+	int rank = 0;
+#ifdef USE_MPI
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+#endif
+	return rank;
+}
+
+int tools::Mpi::ranks()
+{
+	int ranks = 1;
+#ifdef USE_MPI
+	MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+#endif
+	return ranks;
+}
+
+tools::Decomposition::Decomposition(unsigned int size)
+	: m_rank(Mpi::rank()), m_ranks(Mpi::ranks()), m_bounds(m_ranks+1)
+{
+	if (size < (unsigned int) m_ranks)
+		tools::Logger::logger.error("Every process needs at least one cell");
+
+	for (int r = 0; r <= m_ranks; r++)
+		m_bounds[r] = (unsigned long long) size * r / m_ranks;
+}
+
+double tools::Decomposition::minTimeStep(double timeStep) const
+{
+#ifdef USE_MPI
+	double min;
+	MPI_Allreduce(&timeStep, &min, 1, MPI_DOUBLE, MPI_MIN, MPI_COMM_WORLD);
+	return min;
+#else
+	return timeStep;
+#endif
+}
+
+void tools::Decomposition::post()
+{
+#ifdef USE_MPI
+	const int left = m_rank > 0 ? m_rank-1 : MPI_PROC_NULL;
+	const int right = m_rank < m_ranks-1 ? m_rank+1 : MPI_PROC_NULL;
+
+	// Tag 0 travels to the right, tag 1 to the left
+	MPI_Irecv(m_receive, 2, MPI_DOUBLE, left, 0, MPI_COMM_WORLD, &m_requests[0]);
+	MPI_Irecv(m_receive+2, 2, MPI_DOUBLE, right, 1, MPI_COMM_WORLD, &m_requests[1]);
+	MPI_Isend(m_send, 2, MPI_DOUBLE, left, 1, MPI_COMM_WORLD, &m_requests[2]);
+	MPI_Isend(m_send+2, 2, MPI_DOUBLE, right, 0, MPI_COMM_WORLD, &m_requests[3]);
+#endif
+}
+
+void tools::Decomposition::wait()
+{
+#ifdef USE_MPI
+	MPI_Waitall(4, m_requests, MPI_STATUSES_IGNORE);
+#endif
+}
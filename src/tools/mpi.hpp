@@ -0,0 +1,204 @@
+/**
+ * @file mpi.hpp
+ * @brief Distribution of the domain over several processes
+ */
+
+#ifndef TOOLS_MPI_H_
+#define TOOLS_MPI_H_
+
+#include <vector>
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
+
+namespace tools
+{
+
+	/**
+	 * @brief Initializes and finalizes MPI (scons mpi=1)
+	 *
+	 * Without MPI, there is a single process. Only the thread that created the
+	 * object calls MPI, the OpenMP threads and the writers do not.
+	 */
+	class Mpi
+	{
+
+	public:
+
+		/**
+		 * @brief Constructor, initializes MPI
+		 *
+		 * @param argc Argument count
+		 * @param argv Argument buffer
+		 */
+		Mpi(int &argc, char** &argv);
+
+		/**
+		 * @brief Destructor, finalizes MPI
+		 */
+		~Mpi();
+
+		/**
+		 * @brief The rank of this process
+		 */
+		static int rank();
+
+		/**
+		 * @brief Number of processes
+		 */
+		static int ranks();
+
+	};
+
+	/**
+	 * @brief Splits the domain into one contiguous slab of cells per process
+	 *
+	 * Every process stores its slab with one ghost cell on each side (indices 0
+	 * and size()+1), like a domain of its own. Local cell i is cell offset()+i of
+	 * the whole domain. The ghost cells between two slabs hold copies of the
+	 * neighbour's cells, the ghost cells at the ends of the whole domain get the
+	 * outflow condition, as in WavePropagation::setOutflowBoundaryConditions.
+	 *
+	 * The exchange is split into start and finish, so the net-updates of the edges
+	 * that do not touch a ghost cell can be computed in between.
+	 */
+	class Decomposition
+	{
+
+	private:
+
+		/** @brief The rank of this process */
+		int m_rank;
+
+		/** @brief Number of processes */
+		int m_ranks;
+
+		/** @brief The first cell of every slab (offset), and the number of cells at the end */
+		std::vector<unsigned int> m_bounds;
+
+		/** @brief Boundary values sent to the left and right neighbour (h and hu) */
+		double m_send[4];
+
+		/** @brief Ghost values received from the left and right neighbour (h and hu) */
+		double m_receive[4];
+
+#ifdef USE_MPI
+		/** @brief The pending receives and sends */
+		MPI_Request m_requests[4];
+#endif
+
+	public:
+
+		/**
+		 * @brief Constructor, splits the domain evenly
+		 *
+		 * @param size Number of cells of the whole domain
+		 */
+		Decomposition(unsigned int size);
+
+		/**
+		 * @brief The rank of this process
+		 */
+		int rank() const
+		{
+			return m_rank;
+		}
+
+		/**
+		 * @brief Number of processes
+		 */
+		int ranks() const
+		{
+			return m_ranks;
+		}
+
+		/**
+		 * @brief Number of cells of this process (without ghost cells)
+		 */
+		unsigned int size() const
+		{
+			return m_bounds[m_rank+1] - m_bounds[m_rank];
+		}
+
+		/**
+		 * @brief The index of the left ghost cell in the whole domain
+		 */
+		unsigned int offset() const
+		{
+			return m_bounds[m_rank];
+		}
+
+		/**
+		 * @brief The first cell of every slab, and the number of cells at the end
+		 */
+		const std::vector<unsigned int>& bounds() const
+		{
+			return m_bounds;
+		}
+
+		/**
+		 * @brief Sends the boundary cells to the neighbours, does not wait
+		 *
+		 * @param h The water heights of this process
+		 * @param hu The momentums of this process
+		 */
+		template<typename T> void startExchange(const T *h, const T *hu)
+		{
+			m_send[0] = h[1];
+			m_send[1] = hu[1];
+			m_send[2] = h[size()];
+			m_send[3] = hu[size()];
+			post();
+		}
+
+		/**
+		 * @brief Waits for the neighbours and sets the ghost cells
+		 *
+		 * @param h The water heights of this process
+		 * @param hu The momentums of this process
+		 */
+		template<typename T> void finishExchange(T *h, T *hu)
+		{
+			wait();
+
+			const unsigned int n = size();
+			if (m_rank > 0) {
+				h[0] = m_receive[0];
+				hu[0] = m_receive[1];
+			} else {
+				h[0] = h[1];
+				hu[0] = hu[1];
+			}
+			if (m_rank < m_ranks-1) {
+				h[n+1] = m_receive[2];
+				hu[n+1] = m_receive[3];
+			} else {
+				h[n+1] = h[n];
+				hu[n+1] = hu[n];
+			}
+		}
+
+		/**
+		 * @brief The smallest time step of all processes
+		 *
+		 * @param timeStep The time step of this process
+		 */
+		double minTimeStep(double timeStep) const;
+
+	private:
+
+		/**
+		 * @brief Posts the receives and sends of the exchange
+		 */
+		void post();
+
+		/**
+		 * @brief Waits for the receives and sends of the exchange
+		 */
+		void wait();
+
+	};
+
+}
+
+#endif /* TOOLS_MPI_H_ */
@@ -0,0 +1,142 @@
+/**
+ * @file profiler.cpp
+ * @brief Implementation of tools::Profiler and its singleton tools::Profiler::profiler
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include "profiler.hpp"
+#include "logger.hpp"
+
+tools::Profiler tools::Profiler::profiler;
+
+tools::Profiler::Profiler()
+{
+	std::memset(m_phases, 0, sizeof(m_phases));
+	for (unsigned int i = 0; i < PHASES; i++)
+		m_phases[i].min = ~0ull;
+}
+
+void tools::Profiler::add(Phase phase, unsigned long long nanoseconds, unsigned long long cells)
+{
+	Statistics &s = m_phases[phase];
+	s.calls++;
+	s.cells += cells;
+	s.total += nanoseconds;
+	s.min = std::min(s.min, nanoseconds);
+	s.max = std::max(s.max, nanoseconds);
+
+	unsigned int bin = 0;
+	if (nanoseconds > 0)
+		bin = std::min<unsigned int>(std::log2((double) nanoseconds) * BINS_PER_OCTAVE, BINS-1);
+	s.histogram[bin]++;
+}
+
+void tools::Profiler::report(std::ostream &out) const
+{
+	unsigned long long total = 0;
+	for (unsigned int i = 0; i < PHASES; i++)
+		total += m_phases[i].total;
+
+	out << std::left << std::setw(12) << "Phase" << std::right
+		<< std::setw(10) << "Calls" << std::setw(12) << "Total [s]" << std::setw(8) << "Share"
+		<< std::setw(12) << "Min [us]" << std::setw(12) << "Median [us]" << std::setw(12) << "P99 [us]"
+		<< std::setw(12) << "Max [us]" << std::setw(14) << "MCells/s" << std::endl;
+
+	for (unsigned int i = 0; i < PHASES; i++)
+	{
+		const Statistics &s = m_phases[i];
+		if (s.calls == 0)
+			continue;
+
+		out << std::left << std::setw(12) << name(static_cast<Phase>(i)) << std::right << std::fixed
+			<< std::setw(10) << s.calls
+			<< std::setw(12) << std::setprecision(3) << s.total * 1e-9
+			<< std::setw(7) << std::setprecision(1) << 100. * s.total / total << '%'
+			<< std::setw(12) << std::setprecision(1) << s.min * 1e-3
+			<< std::setw(12) << percentile(static_cast<Phase>(i), 50) * 1e-3
+			<< std::setw(12) << percentile(static_cast<Phase>(i), 99) * 1e-3
+			<< std::setw(12) << s.max * 1e-3;
+		if (s.cells > 0)
+			out << std::setw(14) << s.cells / (s.total * 1e-3);
+		out << std::defaultfloat << std::endl;
+	}
+}
+
+void tools::Profiler::writeJson(const std::string &fileName) const
+{
+	std::ofstream out(fileName.c_str());
+	if (!out.good())
+	{
+		tools::Logger::logger.warning() << "Could not open " << fileName << std::endl;
+		return;
+	}
+
+	out << std::setprecision(10) << "{\n  \"phases\": [\n";
+	bool first = true;
+	for (unsigned int i = 0; i < PHASES; i++)
+	{
+		const Statistics &s = m_phases[i];
+		if (s.calls == 0)
+			continue;
+
+		const Phase phase = static_cast<Phase>(i);
+		out << (first ? "" : ",\n")
+			<< "    {\"name\": \"" << name(phase) << "\", \"calls\": " << s.calls
+			<< ", \"cells\": " << s.cells << ", \"totalSeconds\": " << s.total * 1e-9
+			<< ", \"minSeconds\": " << s.min * 1e-9 << ", \"maxSeconds\": " << s.max * 1e-9
+			<< ", \"p50Seconds\": " << percentile(phase, 50) * 1e-9
+			<< ", \"p90Seconds\": " << percentile(phase, 90) * 1e-9
+			<< ", \"p99Seconds\": " << percentile(phase, 99) * 1e-9
+			<< ", \"cellsPerSecond\": " << (s.total > 0 ? s.cells / (s.total * 1e-9) : 0) << "}";
+		first = false;
+	}
+	out << "\n  ]\n}\n";
+}
+
+const char* tools::Profiler::name(Phase phase)
+{
+	switch (phase)
+	{
+	case BOUNDARY:
+		return "boundary";
+	case FLUXES:
+		return "fluxes";
+	case UPDATE:
+		return "update";
+	case FUSED:
+		return "fused";
+	case OUTPUT:
+		return "output";
+	case LOGGING:
+		return "logging";
+	case CHECKPOINT:
+		return "checkpoint";
+	default:
+		return "unknown";
+	}
+}
+
+double tools::Profiler::percentile(Phase phase, double percentile) const
+{
+	const Statistics &s = m_phases[phase];
+	if (s.calls == 0)
+		return 0;
+
+	// First bin that contains the rank, geometric center of the bin
+	const double rank = percentile / 100 * s.calls;
+	unsigned long long count = 0;
+	for (unsigned int bin = 0; bin < BINS; bin++)
+	{
+		count += s.histogram[bin];
+		if (count >= rank && count > 0)
+		{
+			double value = std::exp2((bin + .5) / BINS_PER_OCTAVE);
+			return std::min(std::max(value, (double) s.min), (double) s.max);
+		}
+	}
+	return s.max;
+}
@@ -0,0 +1,172 @@
+/**
+ * @file profiler.hpp
+ * @brief Timers for the phases of the time loop
+ */
+
+#ifndef TOOLS_PROFILER_H_
+#define TOOLS_PROFILER_H_
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+namespace tools
+{
+
+	/**
+	 * @brief Collects the run times of the phases of the time loop
+	 *
+	 * Every phase keeps the number of calls, the total, minimum and maximum time
+	 * and a histogram with 8 bins per power of two nanoseconds, from which the
+	 * percentiles are estimated (relative error below 5%). The memory usage does
+	 * not depend on the number of time steps.
+	 *
+	 * The timers are only compiled in if PROFILE is defined (scons profile=1),
+	 * see PROFILE_SCOPE. The profiler is not thread-safe, phases are timed by the
+	 * thread that runs the time loop.
+	 */
+	class Profiler
+	{
+
+	public:
+
+		/** @brief The phases of a time step */
+		enum Phase { BOUNDARY, FLUXES, UPDATE, FUSED, OUTPUT, LOGGING, CHECKPOINT, PHASES };
+
+	private:
+
+		/** @brief Number of histogram bins per power of two */
+		static const unsigned int BINS_PER_OCTAVE = 8;
+
+		/** @brief Number of histogram bins (up to 2^64 nanoseconds) */
+		static const unsigned int BINS = 64*BINS_PER_OCTAVE;
+
+		/**
+		 * @brief Statistics of one phase
+		 */
+		struct Statistics
+		{
+			/** @brief Number of calls */
+			unsigned long long calls;
+			/** @brief Number of processed cells */
+			unsigned long long cells;
+			/** @brief Total time in nanoseconds */
+			unsigned long long total;
+			/** @brief Shortest call in nanoseconds */
+			unsigned long long min;
+			/** @brief Longest call in nanoseconds */
+			unsigned long long max;
+			/** @brief Logarithmic histogram of the call times */
+			unsigned long long histogram[BINS];
+		};
+
+		/** @brief Statistics of all phases */
+		Statistics m_phases[PHASES];
+
+	public:
+
+		/**
+		 * @brief Constructor
+		 */
+		Profiler();
+
+		/**
+		 * @brief Adds a call of a phase
+		 *
+		 * @param phase The phase
+		 * @param nanoseconds The duration of the call
+		 * @param cells Number of cells processed by the call
+		 */
+		void add(Phase phase, unsigned long long nanoseconds, unsigned long long cells);
+
+		/**
+		 * @brief Prints a table with the statistics of all phases
+		 *
+		 * @param out The output stream
+		 */
+		void report(std::ostream &out) const;
+
+		/**
+		 * @brief Writes the statistics of all phases as JSON
+		 *
+		 * @param fileName The name of the JSON file
+		 */
+		void writeJson(const std::string &fileName) const;
+
+		/**
+		 * @brief The name of a phase
+		 */
+		static const char* name(Phase phase);
+
+		/** @brief The singleton */
+		static Profiler profiler;
+
+	private:
+
+		/**
+		 * @brief Estimates a percentile of the call times of a phase
+		 *
+		 * @param phase The phase
+		 * @param percentile The percentile in [0, 100]
+		 *
+		 * @return The time in nanoseconds
+		 */
+		double percentile(Phase phase, double percentile) const;
+
+	};
+
+	/**
+	 * @brief Times the scope it lives in
+	 */
+	class ScopedTimer
+	{
+
+	private:
+
+		/** @brief The timed phase */
+		Profiler::Phase m_phase;
+
+		/** @brief Number of processed cells */
+		unsigned long long m_cells;
+
+		/** @brief Start of the scope */
+		std::chrono::steady_clock::time_point m_start;
+
+	public:
+
+		/**
+		 * @brief Constructor, starts the timer
+		 *
+		 * @param phase The timed phase
+		 * @param cells Number of cells processed in the scope
+		 */
+		ScopedTimer(Profiler::Phase phase, unsigned long long cells = 0)
+			: m_phase(phase), m_cells(cells), m_start(std::chrono::steady_clock::now())
+		{
+		}
+
+		/**
+		 * @brief Destructor, adds the time to the profiler
+		 */
+		~ScopedTimer()
+		{
+			Profiler::profiler.add(m_phase, std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now() - m_start).count(), m_cells);
+		}
+
+	};
+
+}
+
+/**
+ * @brief Times the rest of the current scope as a phase, with a number of processed cells
+ *
+ * Expands to nothing if PROFILE is not defined.
+ */
+#ifdef PROFILE
+#define PROFILE_SCOPE(phase, cells) tools::ScopedTimer profileScopedTimer_(tools::Profiler::phase, cells)
+#else
+#define PROFILE_SCOPE(phase, cells)
+#endif
+
+#endif /* TOOLS_PROFILER_H_ */
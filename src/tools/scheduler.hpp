@@ -0,0 +1,96 @@
+/**
+ * @file scheduler.hpp
+ * @brief Decides when output is written
+ */
+
+#ifndef TOOLS_SCHEDULER_H_
+#define TOOLS_SCHEDULER_H_
+
+#include <cmath>
+
+namespace tools
+{
+
+	/**
+	 * @brief Selects the time steps that are written
+	 *
+	 * Output is written every N time steps and/or every time a multiple
+	 * of a simulated time interval is passed. If neither is set, every
+	 * time step is written. The initial data is always written.
+	 */
+	class OutputScheduler
+	{
+
+	private:
+
+		/** @brief Write every m_stepInterval time steps (0 = disabled) */
+		unsigned int m_stepInterval;
+
+		/** @brief Write every m_timeInterval simulated time (0 = disabled) */
+		double m_timeInterval;
+
+		/** @brief The next simulated time that should be written */
+		double m_nextTime;
+
+	public:
+
+		/**
+		 * @brief Constructor
+		 *
+		 * @param stepInterval Write every stepInterval time steps (0 = disabled)
+		 * @param timeInterval Write every timeInterval simulated time (0 = disabled)
+		 */
+		OutputScheduler(unsigned int stepInterval = 0, double timeInterval = 0)
+			: m_stepInterval(stepInterval), m_timeInterval(timeInterval), m_nextTime(timeInterval)
+		{
+		}
+
+		/**
+		 * @brief Continues a simulation that was restarted at a simulated time
+		 *
+		 * @param time The simulated time of the restart
+		 */
+		void resume(double time)
+		{
+			if (m_timeInterval > 0)
+				m_nextTime = (std::floor(time / m_timeInterval) + 1) * m_timeInterval;
+		}
+
+		/**
+		 * @brief Checks whether a time step should be written
+		 *
+		 * Has to be called once for every time step, in order.
+		 *
+		 * @param step The number of the time step (0 = initial data)
+		 * @param time The simulated time after this step
+		 *
+		 * @return True if the time step should be written
+		 */
+		bool due(unsigned int step, double time)
+		{
+			if (step == 0)
+				return true;
+
+			if (m_stepInterval == 0 && m_timeInterval <= 0)
+				return true;
+
+			bool write = false;
+
+			if (m_stepInterval > 0 && step % m_stepInterval == 0)
+				write = true;
+
+			if (m_timeInterval > 0 && time >= m_nextTime)
+			{
+				write = true;
+				// Skip intervals that were passed in a single step
+				m_nextTime = (std::floor(time / m_timeInterval) + 1) * m_timeInterval;
+			}
+
+			return write;
+		}
+
+	};
+
+}
+
+#endif /* TOOLS_SCHEDULER_H_ */
@@ -0,0 +1,71 @@
+/**
+ * @file threads.hpp
+ * @brief Helpers for splitting work between threads
+ */
+
+#ifndef TOOLS_THREADS_H_
+#define TOOLS_THREADS_H_
+
+#include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace tools
+{
+
+	/**
+	 * @brief Computes the part of a range that belongs to the calling thread
+	 *
+	 * Inside a parallel region the range is split into contiguous chunks,
+	 * outside of it the whole range is returned.
+	 *
+	 * @param first The first index of the range
+	 * @param last One past the last index of the range
+	 * @param[out] begin The first index of the chunk
+	 * @param[out] end One past the last index of the chunk
+	 *
+	 * @return The number of the calling thread
+	 */
+	inline unsigned int getChunk(unsigned int first, unsigned int last, unsigned int &begin, unsigned int &end)
+	{
+#ifdef _OPENMP
+		unsigned int thread = omp_get_thread_num();
+		unsigned long long threads = omp_get_num_threads();
+#else
+		unsigned int thread = 0;
+		unsigned long long threads = 1;
+#endif
+		unsigned long long length = last - first;
+		begin = first + length * thread / threads;
+		end = first + length * (thread+1) / threads;
+		return thread;
+	}
+
+	/**
+	 * @brief Computes the part of a range that belongs to the calling thread, with aligned chunks
+	 *
+	 * Like getChunk, but all chunks except the last one contain a multiple of granularity
+	 * indices. If index first of an array is aligned, every thread starts at an aligned
+	 * element and no cache line is shared between threads.
+	 *
+	 * @param first The first index of the range
+	 * @param last One past the last index of the range
+	 * @param granularity Number of indices the chunk boundaries are aligned to
+	 * @param[out] begin The first index of the chunk
+	 * @param[out] end One past the last index of the chunk
+	 *
+	 * @return The number of the calling thread
+	 */
+	inline unsigned int getChunk(unsigned int first, unsigned int last, unsigned int granularity,
+		unsigned int &begin, unsigned int &end)
+	{
+		unsigned int thread = getChunk(0, (last - first + granularity-1) / granularity, begin, end);
+		begin = std::min(first + begin*granularity, last);
+		end = std::min(first + end*granularity, last);
+		return thread;
+	}
+
+}
+
+#endif /* TOOLS_THREADS_H_ */
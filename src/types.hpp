@@ -1,14 +0,0 @@
-/**
- * @file types.hpp
- * @brief Provides a precision switch for the generic argument T
- */
-
-#ifndef TYPES_H_
-#define TYPES_H_
-
-
-/** @brief Specifiy precision */
-typedef float T;
-//typedef double T;
-
-#endif /* TYPES_H_ */
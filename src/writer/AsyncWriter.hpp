@@ -0,0 +1,195 @@
+/**
+ * @file AsyncWriter.hpp
+ * @brief Writes data on a background thread
+ */
+
+#ifndef ASYNCWRITER_H_
+#define ASYNCWRITER_H_
+
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace writer
+{
+
+	/**
+	 * @brief Decouples another writer from the time loop
+	 *
+	 * AsyncWriter::write copies the unknowns into one of a fixed number of buffers
+	 * and returns immediately. A background thread passes the buffers to the
+	 * wrapped writer in the same order. If all buffers are in use, AsyncWriter::write
+	 * blocks until the oldest one is written, which bounds the memory usage.
+	 *
+	 * The wrapped writer needs a method write(time, h, hu, b, size, x) for values of type T.
+	 * Only the unknowns are copied, the derived fields are computed by the wrapped writer.
+	 */
+	template<typename T, class Writer> class AsyncWriter
+	{
+
+	private:
+
+		/**
+		 * @brief A copy of the unknowns
+		 */
+		struct Snapshot
+		{
+			/** @brief Simulation time */
+			T time;
+			/** @brief Number of cells (without boundary values) */
+			unsigned int size;
+			/** @brief Water heights, momentums and bathymetries (with boundary values) */
+			std::vector<T> data;
+			/** @brief Grid points of a non-uniform grid, empty for a uniform grid */
+			std::vector<T> coordinates;
+		};
+
+		/** @brief The writer that does the actual work */
+		Writer &m_writer;
+
+		/** @brief All buffers */
+		std::vector<Snapshot> m_snapshots;
+
+		/** @brief Buffers that are not in use */
+		std::deque<Snapshot*> m_free;
+
+		/** @brief Buffers that have to be written, oldest first */
+		std::deque<Snapshot*> m_queue;
+
+		/** @brief Protects the free list and the queue */
+		std::mutex m_mutex;
+
+		/** @brief Signals a new buffer in the queue or the end of the simulation */
+		std::condition_variable m_queued;
+
+		/** @brief Signals a buffer that is free again */
+		std::condition_variable m_released;
+
+		/** @brief Set when no more data will be written */
+		bool m_finished;
+
+		/** @brief The background thread */
+		std::thread m_thread;
+
+	public:
+
+		/**
+		 * @brief Constructor
+		 *
+		 * @param writer The writer that is used in the background
+		 * @param buffers Number of buffers, the data is written synchronously if this is zero
+		 */
+		AsyncWriter(Writer &writer, unsigned int buffers = 2)
+			: m_writer(writer), m_snapshots(buffers), m_finished(false)
+		{
+			for (unsigned int i = 0; i < buffers; i++)
+				m_free.push_back(&m_snapshots[i]);
+
+			if (buffers > 0)
+				m_thread = std::thread(&AsyncWriter::run, this);
+		}
+
+		/**
+		 * @brief Destructor, waits until all data is written
+		 */
+		~AsyncWriter()
+		{
+			if (m_thread.joinable())
+			{
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					m_finished = true;
+				}
+				m_queued.notify_one();
+				m_thread.join();
+			}
+		}
+
+		/**
+		 * @brief Copies all values and writes them in the background
+		 *
+		 * @param time Current time
+		 * @param h Current height
+		 * @param hu Current flux
+		 * @param b Current bathymetry
+		 * @param size Number of cells (without boundary values)
+		 * @param x The size+1 grid points of a non-uniform grid, null for a uniform grid
+		 */
+		void write(const T time, const T *h, const T *hu, const T *b, unsigned int size,
+			const T *x = 0L)
+		{
+			if (!m_thread.joinable())
+			{
+				m_writer.write(time, h, hu, b, size, x);
+				return;
+			}
+
+			// Wait for a free buffer
+			Snapshot *snapshot;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				while (m_free.empty())
+					m_released.wait(lock);
+				snapshot = m_free.front();
+				m_free.pop_front();
+			}
+
+			snapshot->time = time;
+			snapshot->size = size;
+			snapshot->data.resize(3*(size+2));
+			std::memcpy(&snapshot->data[0], h, (size+2)*sizeof(T));
+			std::memcpy(&snapshot->data[size+2], hu, (size+2)*sizeof(T));
+			std::memcpy(&snapshot->data[2*(size+2)], b, (size+2)*sizeof(T));
+			if (x)
+				snapshot->coordinates.assign(x, x+size+1);
+			else
+				snapshot->coordinates.clear();
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_queue.push_back(snapshot);
+			}
+			m_queued.notify_one();
+		}
+
+	private:
+
+		/**
+		 * @brief Main loop of the background thread
+		 */
+		void run()
+		{
+			while (true)
+			{
+				Snapshot *snapshot;
+				{
+					std::unique_lock<std::mutex> lock(m_mutex);
+					while (m_queue.empty() && !m_finished)
+						m_queued.wait(lock);
+					if (m_queue.empty())
+						return;
+					snapshot = m_queue.front();
+					m_queue.pop_front();
+				}
+
+				const T *data = &snapshot->data[0];
+				const unsigned int n = snapshot->size+2;
+				const T *x = snapshot->coordinates.empty() ? 0L : &snapshot->coordinates[0];
+				m_writer.write(snapshot->time, data, data+n, data+2*n, snapshot->size, x);
+
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					m_free.push_back(snapshot);
+				}
+				m_released.notify_one();
+			}
+		}
+
+	};
+
+}
+
+#endif /* ASYNCWRITER_H_ */
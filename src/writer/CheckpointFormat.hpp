@@ -0,0 +1,82 @@
+/**
+ * @file CheckpointFormat.hpp
+ * @brief Layout of the checkpoint files
+ *
+ * A checkpoint file consists of
+ * - a CheckpointHeader,
+ * - the fields h, hu and b including the boundary values, each padded to
+ *   CHECKPOINT_ALIGNMENT bytes.
+ *
+ * The state of the solver is completely defined by these fields, so a checkpoint
+ * does not depend on the number of threads. Checkpoints are written to a temporary
+ * file that replaces the previous checkpoint once it is complete.
+ * All values are stored in the byte order of the machine that wrote the file.
+ */
+
+#ifndef CHECKPOINTFORMAT_H_
+#define CHECKPOINTFORMAT_H_
+
+#include <stdint.h>
+
+namespace writer
+{
+
+	/** @brief Magic number at the start of a checkpoint file */
+	const char CHECKPOINT_MAGIC[8] = {'S', 'W', 'E', '1', 'D', 'C', 'P', 0};
+
+	/** @brief Current version of the format */
+	const uint32_t CHECKPOINT_VERSION = 2;
+
+	/** @brief Alignment of the header and the fields */
+	const uint64_t CHECKPOINT_ALIGNMENT = 64;
+
+	/** @brief Number of fields */
+	const unsigned int CHECKPOINT_FIELDS = 3;
+
+	/**
+	 * @brief Header at the start of the file
+	 */
+	struct CheckpointHeader
+	{
+		/** @brief CHECKPOINT_MAGIC */
+		char magic[8];
+		/** @brief CHECKPOINT_VERSION */
+		uint32_t version;
+		/** @brief Size of a value in bytes (4 or 8) */
+		uint32_t scalarSize;
+		/** @brief Number of cells (without boundary values) */
+		uint32_t cells;
+		/** @brief Number of fields */
+		uint32_t fields;
+		/** @brief Size of a cell */
+		double cellSize;
+		/** @brief Simulation time */
+		double time;
+		/** @brief Number of time steps done */
+		uint64_t step;
+		/** @brief Number of outputs written */
+		uint64_t outputs;
+		/** @brief Offset of the first field */
+		uint64_t dataOffset;
+		/** @brief Size of the file in bytes */
+		uint64_t fileSize;
+		/** @brief Name of the scenario */
+		char scenario[32];
+		/** @brief Padding to CHECKPOINT_ALIGNMENT */
+		char padding[24];
+	};
+
+	/**
+	 * @brief Computes the size of a padded field
+	 *
+	 * @param cells Number of cells (without boundary values)
+	 * @param scalarSize Size of a value in bytes
+	 */
+	inline uint64_t checkpointFieldSize(uint64_t cells, uint64_t scalarSize)
+	{
+		return ((cells+2) * scalarSize + CHECKPOINT_ALIGNMENT - 1) / CHECKPOINT_ALIGNMENT * CHECKPOINT_ALIGNMENT;
+	}
+
+}
+
+#endif /* CHECKPOINTFORMAT_H_ */
@@ -0,0 +1,198 @@
+/**
+ * @file CheckpointWriter.hpp
+ * @brief Writes the state of the solver for restarts
+ */
+
+#ifndef CHECKPOINTWRITER_H_
+#define CHECKPOINTWRITER_H_
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "CheckpointFormat.hpp"
+#include "../tools/logger.hpp"
+
+namespace writer
+{
+
+	/**
+	 * @brief A writer class that saves checkpoints
+	 *
+	 * Every checkpoint is written to fileName.tmp, flushed to the disk and renamed
+	 * to fileName afterwards, so fileName always contains a complete checkpoint,
+	 * even if the simulation is killed while writing. See CheckpointFormat.hpp for
+	 * the layout of the file and reader::CheckpointReader for restarts.
+	 *
+	 * In asynchronous mode, the fields are copied and written by a background thread.
+	 * A new checkpoint waits until the previous one is written.
+	 */
+	template<typename T> class CheckpointWriter
+	{
+
+	private:
+
+		/** @brief The name of the checkpoint file */
+		std::string m_fileName;
+
+		/** @brief Header of the next checkpoint */
+		CheckpointHeader m_header;
+
+		/** @brief Write in the background */
+		bool m_async;
+
+		/** @brief Copy of the fields (asynchronous mode only) */
+		std::vector<T> m_buffer;
+
+		/** @brief The background thread of the last checkpoint (asynchronous mode only) */
+		std::thread m_thread;
+
+	public:
+
+		/**
+		 * @brief Constructor
+		 *
+		 * @param fileName The name of the checkpoint file
+		 * @param scenario The name of the scenario, checked on restart
+		 * @param cellSize The size of a cell
+		 * @param async Write the checkpoints in the background
+		 */
+		CheckpointWriter(const std::string &fileName, const std::string &scenario, T cellSize,
+				bool async = false)
+			: m_fileName(fileName), m_async(async)
+		{
+			std::memset(&m_header, 0, sizeof(m_header));
+			std::memcpy(m_header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+			m_header.version = CHECKPOINT_VERSION;
+			m_header.scalarSize = sizeof(T);
+			m_header.fields = CHECKPOINT_FIELDS;
+			m_header.cellSize = cellSize;
+			m_header.dataOffset = sizeof(CheckpointHeader);
+			std::strncpy(m_header.scenario, scenario.c_str(), sizeof(m_header.scenario)-1);
+		}
+
+		/**
+		 * @brief Destructor, waits for the last checkpoint
+		 */
+		~CheckpointWriter()
+		{
+			if (m_thread.joinable())
+				m_thread.join();
+		}
+
+		/**
+		 * @brief Saves a checkpoint
+		 *
+		 * @param time Current time
+		 * @param step Number of time steps done
+		 * @param outputs Number of outputs written
+		 * @param h Current height
+		 * @param hu Current flux
+		 * @param b Current bathymetry
+		 * @param size Number of cells (without boundary values)
+		 */
+		void write(double time, unsigned long long step, unsigned long long outputs,
+			const T *h, const T *hu, const T *b, unsigned int size)
+		{
+			if (m_thread.joinable())
+				m_thread.join();
+
+			m_header.time = time;
+			m_header.step = step;
+			m_header.outputs = outputs;
+			m_header.cells = size;
+			m_header.fileSize = m_header.dataOffset + CHECKPOINT_FIELDS * checkpointFieldSize(size, sizeof(T));
+
+			if (!m_async)
+			{
+				const T *fields[CHECKPOINT_FIELDS] = {h, hu, b};
+				writeFile(m_header, fields);
+				return;
+			}
+
+			const unsigned int n = size+2;
+			m_buffer.resize(CHECKPOINT_FIELDS*n);
+			std::memcpy(&m_buffer[0], h, n*sizeof(T));
+			std::memcpy(&m_buffer[n], hu, n*sizeof(T));
+			std::memcpy(&m_buffer[2*n], b, n*sizeof(T));
+
+			m_thread = std::thread(&CheckpointWriter::writeBuffer, this, m_header);
+		}
+
+	private:
+
+		/**
+		 * @brief Writes the copied fields (background thread)
+		 */
+		void writeBuffer(CheckpointHeader header)
+		{
+			const unsigned int n = header.cells+2;
+			const T *fields[CHECKPOINT_FIELDS] = {&m_buffer[0], &m_buffer[n], &m_buffer[2*n]};
+			writeFile(header, fields);
+		}
+
+		/**
+		 * @brief Writes the temporary file and replaces the checkpoint
+		 *
+		 * Failures are logged as warnings, the previous checkpoint stays valid.
+		 */
+		void writeFile(const CheckpointHeader &header, const T **fields)
+		{
+			const std::string tmpName = m_fileName + ".tmp";
+
+			int fd = open(tmpName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+			if (fd < 0)
+			{
+				tools::Logger::logger.warning() << "Could not open " << tmpName << ": " << std::strerror(errno) << std::endl;
+				return;
+			}
+
+			const uint64_t fieldSize = checkpointFieldSize(header.cells, sizeof(T));
+			const std::vector<char> padding(CHECKPOINT_ALIGNMENT, 0);
+
+			bool ok = writeAll(fd, &header, sizeof(header));
+			for (unsigned int i = 0; i < CHECKPOINT_FIELDS && ok; i++)
+			{
+				const uint64_t bytes = (header.cells+2) * sizeof(T);
+				ok = writeAll(fd, fields[i], bytes) && writeAll(fd, &padding[0], fieldSize - bytes);
+			}
+
+			// The data has to be on the disk before the old checkpoint is replaced
+			ok = ok && fsync(fd) == 0;
+			ok = close(fd) == 0 && ok;
+			ok = ok && std::rename(tmpName.c_str(), m_fileName.c_str()) == 0;
+
+			if (!ok)
+				tools::Logger::logger.warning() << "Could not write checkpoint " << m_fileName << ": " << std::strerror(errno) << std::endl;
+		}
+
+		/**
+		 * @brief Writes a buffer completely, retries after interrupts and partial writes
+		 */
+		static bool writeAll(int fd, const void *data, uint64_t bytes)
+		{
+			const char *p = static_cast<const char*>(data);
+			while (bytes > 0)
+			{
+				ssize_t written = ::write(fd, p, bytes);
+				if (written < 0)
+				{
+					if (errno == EINTR)
+						continue;
+					return false;
+				}
+				p += written;
+				bytes -= written;
+			}
+			return true;
+		}
+
+	};
+
+}
+
+#endif /* CHECKPOINTWRITER_H_ */
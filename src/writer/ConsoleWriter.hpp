@@ -1,13 +1,21 @@
 /**
  * @file ConsoleWriter.hpp
- * @brief Writes data to an output stream
+ * @brief Writes data as CSV or TSV text to stdout (or another file descriptor)
  */
 
 #ifndef CONSOLEWRITER_H_
 #define CONSOLEWRITER_H_
 
-#include <iostream>
-#include "../types.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+#include "DerivedFields.hpp"
+#include "../tools/logger.hpp"
+#include "../tools/threads.hpp"
 
 /**
  * @brief A Collection of different data writers
@@ -16,43 +24,277 @@ namespace writer
 {
 
 	/**
-	 * @brief A simple writer class, that writes data to stdout (or another ostream)
+	 * @brief Streams the cells as text rows to stdout (or another file descriptor)
+	 *
+	 * Every row holds time, x (the center of the cell), h, hu, b and the derived
+	 * fields of one cell, the first frame starts with a header. The values are
+	 * formatted with std::to_chars, independent of the locale, into buffers that
+	 * are reused by all frames. Every thread formats a contiguous chunk of rows,
+	 * the chunks are joined and the frame is passed to the file descriptor with a
+	 * single write(2).
 	 */
-	class ConsoleWriter
+	template<typename T> class ConsoleWriter
 	{
-		
+
+		public:
+
+			/** @brief The separator of the columns */
+			enum Format { CSV, TSV };
+
+			/** @brief A region of cells [first, last) that is written */
+			typedef std::pair<unsigned int, unsigned int> Region;
+
+			/** @brief Maximum number of characters of a value with its separator */
+			static const unsigned int MAX_CHARS = 32;
+
+			/** @brief Maximum number of significant digits with a fixed precision */
+			static const int MAX_PRECISION = 17;
+
 		private:
 
-			/** @brief The output stream */
-			std::ostream &m_ostream;
+			/** @brief The file descriptor */
+			int m_fd;
+
+			/** @brief Cell size */
+			T m_cellSize;
+
+			/** @brief The separator of the columns */
+			char m_separator;
+
+			/** @brief Number of significant digits, shortest representation that round-trips if negative */
+			int m_precision;
+
+			/** @brief Number of threads that format the rows */
+			unsigned int m_threads;
+
+			/** @brief The header is written with the first frame */
+			bool m_header;
+
+			/** @brief Approximate the froude numbers with the reciprocal square root */
+			bool m_fastFroude;
+
+			/** @brief The regions that are written, the whole domain if empty */
+			std::vector<Region> m_regions;
+
+			/** @brief The derived fields of the current region */
+			std::vector<T> m_fields;
+
+			/** @brief The rows formatted by every thread */
+			std::vector<std::vector<char> > m_chunks;
+
+			/** @brief The position of the chunk of every thread in the frame */
+			std::vector<size_t> m_offsets;
+
+			/** @brief The text of the current frame */
+			std::vector<char> m_buffer;
 
 		public:
 
 			/**
 			 * @brief Constructor
-			 * 
-			 * @param ostream The output stream
+			 *
+			 * @param cellSize The size of a cell
+			 * @param format The separator of the columns
+			 * @param precision Number of significant digits, the shortest representation that round-trips if negative
+			 * @param threads Number of threads that format the rows
+			 * @param fd The file descriptor, stdout by default
 			 */
-			ConsoleWriter(std::ostream &ostream = std::cout)
-				: m_ostream(ostream)
+			ConsoleWriter(const T cellSize = 1, Format format = CSV, int precision = -1,
+				unsigned int threads = 1, int fd = STDOUT_FILENO)
+				: m_fd(fd), m_cellSize(cellSize), m_separator(format == TSV ? '\t' : ','),
+				  m_precision(precision > MAX_PRECISION ? MAX_PRECISION : precision),
+				  m_threads(std::max(threads, 1u)), m_header(true), m_fastFroude(false),
+				  m_chunks(m_threads), m_offsets(m_threads+1)
 			{
 			}
 
 			/**
-			 * @brief Writes all values (without boundary values) to the ostream
+			 * @brief Restricts the output to some regions of the domain
 			 *
+			 * @param regions The regions that should be written, the whole domain if empty
+			 */
+			void setRegions(const std::vector<Region> &regions)
+			{
+				m_regions = regions;
+			}
+
+			/**
+			 * @brief Approximates the froude numbers with the reciprocal square root, see writer::DerivedFields
+			 *
+			 * @param fast Use the fast mode of kernels::CellBatch
+			 */
+			void setFastFroude(bool fast)
+			{
+				m_fastFroude = fast;
+			}
+
+			/**
+			 * @brief Writes all values as one frame
+			 *
+			 * @param time Current time
 			 * @param h Water height
 			 * @param hu Water flux
+			 * @param b Bathymetry
 			 * @param size Number of cells (without boundary values)
+			 * @param x The size+1 grid points of a non-uniform grid, null for a uniform grid
+			 */
+			void write(const T time, const T *h, const T *hu, const T *b, unsigned int size,
+				const T *x = 0L)
+			{
+				size_t length = 0;
+				if (m_header)
+				{
+					const char *columns[] = {"time", "x", "h", "hu", "b"};
+					for (unsigned int i = 0; i < 5; i++)
+						length = append(length, columns[i]);
+					for (unsigned int i = 0; i < DerivedFields<T>::FIELDS; i++)
+						length = append(length, DerivedFields<T>::name(static_cast<typename DerivedFields<T>::Field>(i)));
+					m_buffer[length-1] = '\n';
+					m_header = false;
+				}
+
+				// The time is the same in every row
+				char timeText[MAX_CHARS];
+				const unsigned int timeLength = format(timeText, time) - timeText;
+
+				if (m_regions.empty())
+					length = writeRegion(length, timeText, timeLength, h, hu, b, x, 0, size);
+				for (unsigned int part = 0; part < m_regions.size(); part++)
+				{
+					unsigned int first = std::min(m_regions[part].first, size);
+					unsigned int last = std::min(m_regions[part].second, size);
+					if (first < last)
+						length = writeRegion(length, timeText, timeLength, h, hu, b, x, first, last);
+				}
+
+				if (length > 0)
+					flush(&m_buffer[0], length);
+			}
+
+		private:
+
+			/**
+			 * @brief Appends the rows of the cells [first, last) to the frame
+			 *
+			 * @param length The length of the frame so far
+			 *
+			 * @return The new length of the frame
 			 */
-			void write(const T *h, const T *hu, unsigned int size)
+			size_t writeRegion(size_t length, const char *timeText, unsigned int timeLength,
+				const T *h, const T *hu, const T *b, const T *x, unsigned int first, unsigned int last)
 			{
-				for (unsigned int i=1; i < size+1; i++)  m_ostream << h[i] << ' ';
-				m_ostream << '\n';	// do not flush the buffer here (do not use std::endl)
-				for (unsigned int i=1; i < size+1; i++)  m_ostream << hu[i] << ' ';
-				m_ostream << std::endl;
+				const unsigned int fields = DerivedFields<T>::FIELDS;
+				const unsigned int cells = last - first;
+				m_fields.resize(fields * cells);
+
+				// Threads that do not run leave their chunk empty
+				std::fill(m_offsets.begin(), m_offsets.end(), 0);
+
+				#pragma omp parallel num_threads(m_threads)
+				{
+					unsigned int begin, end;
+					const unsigned int thread = tools::getChunk(first, last, begin, end);
+
+					DerivedFields<T> derived(m_fastFroude);
+					for (unsigned int j = 0; j < fields; j++)
+						derived.compute(static_cast<typename DerivedFields<T>::Field>(j), h, hu, b,
+							begin+1, end+1, &m_fields[j*cells + begin-first]);
+
+					std::vector<char> &chunk = m_chunks[thread];
+					const size_t rowSize = timeLength + (4+fields) * MAX_CHARS;
+					size_t used = 0;
+					for (unsigned int i = begin; i < end; i++)
+					{
+						if (used + rowSize > chunk.size())
+							chunk.resize(std::max(2 * chunk.size(), used + rowSize));
+						char *p = &chunk[used];
+
+						std::memcpy(p, timeText, timeLength);
+						p += timeLength;
+						*p++ = m_separator;
+						p = format(p, x ? (x[i] + x[i+1]) / 2 : m_cellSize * ((T) i + (T) .5));
+						*p++ = m_separator;
+						p = format(p, h[i+1]);
+						*p++ = m_separator;
+						p = format(p, hu[i+1]);
+						*p++ = m_separator;
+						p = format(p, b[i+1]);
+						for (unsigned int j = 0; j < fields; j++)
+						{
+							*p++ = m_separator;
+							p = format(p, m_fields[j*cells + i-first]);
+						}
+						*p++ = '\n';
+
+						used = p - &chunk[0];
+					}
+					m_offsets[thread+1] = used;
+
+					#pragma omp barrier
+					#pragma omp single
+					{
+						m_offsets[0] = length;
+						for (unsigned int t = 0; t < m_threads; t++)
+							m_offsets[t+1] += m_offsets[t];
+						if (m_buffer.size() < m_offsets[m_threads])
+							m_buffer.resize(m_offsets[m_threads]);
+					}
+
+					// Join the chunks in the frame
+					if (m_offsets[thread+1] > m_offsets[thread])
+						std::memcpy(&m_buffer[m_offsets[thread]], &chunk[0], m_offsets[thread+1] - m_offsets[thread]);
+				}
+
+				return m_offsets[m_threads];
 			}
-			
+
+			/**
+			 * @brief Appends a column name and a separator to the frame
+			 *
+			 * @return The new length of the frame
+			 */
+			size_t append(size_t length, const char *name)
+			{
+				const size_t nameLength = std::strlen(name);
+				if (m_buffer.size() < length + nameLength + 1)
+					m_buffer.resize(length + nameLength + 1);
+				std::memcpy(&m_buffer[length], name, nameLength);
+				m_buffer[length + nameLength] = m_separator;
+				return length + nameLength + 1;
+			}
+
+			/**
+			 * @brief Formats a value, at most MAX_CHARS-1 characters
+			 *
+			 * @return The end of the text
+			 */
+			char* format(char *p, T value) const
+			{
+				if (m_precision < 0)
+					return std::to_chars(p, p + MAX_CHARS-1, value).ptr;
+				return std::to_chars(p, p + MAX_CHARS-1, value, std::chars_format::general, m_precision).ptr;
+			}
+
+			/**
+			 * @brief Passes the text to the file descriptor
+			 */
+			void flush(const char *text, size_t length)
+			{
+				// Pipes may accept only a part of the frame
+				while (length > 0)
+				{
+					const ssize_t written = ::write(m_fd, text, length);
+					if (written < 0)
+					{
+						if (errno == EINTR)
+							continue;
+						tools::Logger::logger.error("Could not write the text output");
+					}
+					text += written;
+					length -= written;
+				}
+			}
+
 	};
 
 }
@@ -0,0 +1,114 @@
+/**
+ * @file DerivedFields.hpp
+ * @brief Diagnostics that are computed from the unknowns when they are written
+ */
+
+#ifndef DERIVEDFIELDS_H_
+#define DERIVEDFIELDS_H_
+
+#include "../../submodules/solvers/src/solver/FWave.hpp"
+#include "../kernels/CellBatch.hpp"
+
+namespace writer
+{
+
+	/**
+	 * @brief The fields of the output that are not stored by the solvers
+	 *
+	 * The solvers only keep h, hu and b. The writers compute the derived fields
+	 * of the cells they write in the same pass that serializes them, so time steps
+	 * that are not written do not compute them at all. The values are computed
+	 * with the precision of the output, the froude numbers of many cells by the
+	 * SIMD kernel kernels::CellBatch.
+	 */
+	template<typename T> class DerivedFields
+	{
+
+	public:
+
+		/** @brief The derived fields, in the order they are written */
+		enum Field { SURFACE, FROUDE, FIELDS };
+
+	private:
+
+		/** @brief The solver that defines the froude number */
+		solver::FWave<T> m_solver;
+
+		/** @brief Computes the froude numbers of many cells */
+		kernels::CellBatch<T> m_kernel;
+
+	public:
+
+		/**
+		 * @brief Constructor
+		 *
+		 * @param fast Approximate the froude numbers with the reciprocal square root
+		 *  (a few ulp, see kernels::CellBatch), otherwise they match solver::FWave::computeFroude
+		 */
+		DerivedFields(bool fast = false)
+			: m_kernel(fast)
+		{
+		}
+
+		/**
+		 * @brief Selects the mode of the froude numbers, see the constructor
+		 *
+		 * @param fast Approximate the froude numbers with the reciprocal square root
+		 */
+		void setFast(bool fast)
+		{
+			m_kernel = kernels::CellBatch<T>(fast);
+		}
+
+		/**
+		 * @brief The name of a field in the output
+		 */
+		static const char* name(Field field)
+		{
+			return field == SURFACE ? "b+h" : "f";
+		}
+
+		/**
+		 * @brief The value of a field in one cell
+		 *
+		 * @param field The field
+		 * @param h Water height
+		 * @param hu Momentum
+		 * @param b Bathymetry
+		 */
+		T value(Field field, T h, T hu, T b)
+		{
+			if (field == SURFACE)
+				return b + h;
+			return m_solver.computeFroude(h, hu);
+		}
+
+		/**
+		 * @brief Computes a field for the cells [first, last)
+		 *
+		 * @param field The field
+		 * @param h Water heights
+		 * @param hu Momentums
+		 * @param b Bathymetries
+		 * @param first The first cell
+		 * @param last One past the last cell
+		 * @param[out] values The last-first values of the field
+		 */
+		void compute(Field field, const T *h, const T *hu, const T *b,
+			unsigned int first, unsigned int last, T *values)
+		{
+			if (field == SURFACE)
+			{
+				for (unsigned int i = first; i < last; i++)
+					values[i-first] = b[i] + h[i];
+				return;
+			}
+
+			m_kernel.computeFroude(h+first, hu+first, values, 0, last-first);
+		}
+
+	};
+
+}
+
+#endif /* DERIVEDFIELDS_H_ */
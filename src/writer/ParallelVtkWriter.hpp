@@ -0,0 +1,182 @@
+/**
+ * @file ParallelVtkWriter.hpp
+ * @brief Writes a distributed domain as parallel VTK files
+ */
+
+#ifndef PARALLELVTKWRITER_H_
+#define PARALLELVTKWRITER_H_
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "VtkWriter.hpp"
+
+namespace writer
+{
+
+	/**
+	 * @brief Writes the slab of every process as a piece of a parallel VTK file
+	 *
+	 * Every process writes its cells to basename_rank<r>_<n>.vtr with the extent and
+	 * the coordinates of the whole domain. The first process also writes
+	 * basename_<n>.pvtr, which combines the pieces of all processes, and the
+	 * collection basename.vtp of the pvtr files. The processes do not communicate,
+	 * the pieces are known from the decomposition.
+	 */
+	template<typename T> class ParallelVtkWriter
+	{
+
+	private:
+
+		/** @brief Base name of the files */
+		std::string m_basename;
+
+		/** @brief The rank of this process */
+		int m_rank;
+
+		/** @brief The first cell of every slab, and the number of cells at the end */
+		std::vector<unsigned int> m_bounds;
+
+		/** @brief Encoding of the data arrays */
+		typename VtkWriter<T>::Format m_format;
+
+		/** @brief Writes the piece of this process */
+		VtkWriter<T> m_piece;
+
+		/** @brief Current time step */
+		unsigned int m_timeStep;
+
+		/** @brief The collection of the pvtr files (first process only) */
+		std::ofstream m_collection;
+
+	public:
+
+		/**
+		 * @brief Constructor
+		 *
+		 * @param basename The filename of the output files without extension
+		 * @param cellSize The size of a cell
+		 * @param format The encoding of the data arrays
+		 * @param rank The rank of this process
+		 * @param bounds The first cell of every slab, and the number of cells at the end
+		 */
+		ParallelVtkWriter(const std::string &basename, const T cellSize, typename VtkWriter<T>::Format format,
+			int rank, const std::vector<unsigned int> &bounds)
+			: m_basename(basename), m_rank(rank), m_bounds(bounds), m_format(format),
+			  m_piece(pieceName(rank), cellSize, format, 0, false), m_timeStep(0)
+		{
+			m_piece.setPiece(bounds[rank], bounds.back());
+
+			if (m_rank == 0)
+			{
+				m_collection.open((m_basename + ".vtp").c_str());
+				m_collection << "<?xml version=\"1.0\"?>" << std::endl
+					<< "<VTKFile type=\"Collection\" version=\"0.1\">" << std::endl
+					<< "<Collection>" << std::endl;
+			}
+		}
+
+		/**
+		 * @brief Destructor
+		 */
+		~ParallelVtkWriter()
+		{
+			if (m_rank == 0)
+				m_collection << "</Collection>" << std::endl
+					<< "</VTKFile>" << std::endl;
+		}
+
+		/**
+		 * @brief Approximates the froude numbers of the pieces, see VtkWriter::setFastFroude
+		 */
+		void setFastFroude(bool fast)
+		{
+			m_piece.setFastFroude(fast);
+		}
+
+		/**
+		 * @brief Compresses the binary arrays of the pieces, see VtkWriter::setCompression
+		 */
+		void setCompression(tools::Compression::Method compression, unsigned int blockSize = 32768,
+			int level = -1, unsigned int threads = 1)
+		{
+			m_piece.setCompression(compression, blockSize, level, threads);
+		}
+
+		/**
+		 * @brief Writes the piece of this process (and the parallel file)
+		 *
+		 * @param time Current time
+		 * @param h Current height
+		 * @param hu Current flux
+		 * @param b Current bathymetry
+		 * @param size Number of cells of this process (without boundary values)
+		 * @param x The size+1 grid points of the piece, null for a uniform grid
+		 */
+		void write(const T time, const T *h, const T *hu, const T *b, unsigned int size,
+			const T *x = 0L)
+		{
+			m_piece.write(time, h, hu, b, size, x);
+
+			if (m_rank == 0)
+				writeParallel(time);
+
+			m_timeStep++;
+		}
+
+	private:
+
+		/**
+		 * @brief Writes the pvtr file of the current time step and adds it to the collection
+		 */
+		void writeParallel(const T time)
+		{
+			std::ostringstream fileName;
+			fileName << m_basename << '_' << m_timeStep << ".pvtr";
+
+			m_collection << "<DataSet timestep=\"" << time << "0\" group=\"\" part=\"0\" file=\""
+				<< fileName.str() << "\"/> " << std::endl;
+
+			const char *type = m_format == VtkWriter<T>::BINARY && sizeof(T) == 8 ? "Float64" : "Float32";
+			const char *arrays[] = {"h", "hu", "b"};
+
+			std::ofstream pvtrFile(fileName.str().c_str());
+			pvtrFile << "<?xml version=\"1.0\"?>" << std::endl
+				<< "<VTKFile type=\"PRectilinearGrid\" version=\"0.1\">" << std::endl
+				<< "<PRectilinearGrid WholeExtent=\"0 " << m_bounds.back() << " 0 0 0 0\" GhostLevel=\"0\">" << std::endl
+				<< "<PCoordinates>" << std::endl;
+			for (unsigned int i = 0; i < 3; i++)
+				pvtrFile << "<PDataArray type=\"" << type << "\"/>" << std::endl;
+			pvtrFile << "</PCoordinates>" << std::endl
+				<< "<PCellData>" << std::endl;
+			for (unsigned int i = 0; i < 3; i++)
+				pvtrFile << "<PDataArray Name=\"" << arrays[i] << "\" type=\"" << type << "\"/>" << std::endl;
+			for (unsigned int i = 0; i < DerivedFields<T>::FIELDS; i++)
+				pvtrFile << "<PDataArray Name=\"" << DerivedFields<T>::name(static_cast<typename DerivedFields<T>::Field>(i))
+					<< "\" type=\"" << type << "\"/>" << std::endl;
+			pvtrFile << "</PCellData>" << std::endl;
+
+			for (unsigned int r = 0; r+1 < m_bounds.size(); r++)
+				pvtrFile << "<Piece Extent=\"" << m_bounds[r] << " " << m_bounds[r+1] << " 0 0 0 0\" Source=\""
+					<< pieceName(r) << '_' << m_timeStep << ".vtr\"/>" << std::endl;
+
+			pvtrFile << "</PRectilinearGrid>" << std::endl
+				<< "</VTKFile>" << std::endl;
+		}
+
+		/**
+		 * @brief The base name of the pieces of a process
+		 */
+		std::string pieceName(int rank) const
+		{
+			std::ostringstream name;
+			name << m_basename << "_rank" << rank;
+			return name.str();
+		}
+
+	};
+
+}
+
+#endif /* PARALLELVTKWRITER_H_ */
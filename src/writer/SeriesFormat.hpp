@@ -0,0 +1,111 @@
+/**
+ * @file SeriesFormat.hpp
+ * @brief Layout of the single-file time series container
+ *
+ * A series file consists of
+ * - a SeriesHeader,
+ * - one block per written time step: a SeriesStepHeader followed by the
+ *   fields h, hu, b and f (without boundary values), each padded to
+ *   SERIES_ALIGNMENT bytes,
+ * - the index: one SeriesIndexEntry per time step.
+ *
+ * All blocks have the same size. The index is written when the file is closed,
+ * until then SeriesHeader::indexOffset is zero. Readers can still access the time
+ * steps of an unfinished file by using the block size.
+ * All values are stored in the byte order of the machine that wrote the file.
+ */
+
+#ifndef SERIESFORMAT_H_
+#define SERIESFORMAT_H_
+
+#include <stdint.h>
+
+namespace writer
+{
+
+	/** @brief Magic number at the start of a series file */
+	const char SERIES_MAGIC[8] = {'S', 'W', 'E', '1', 'D', 'T', 'S', 0};
+
+	/** @brief Current version of the format */
+	const uint32_t SERIES_VERSION = 1;
+
+	/** @brief Alignment of the header, the blocks and the fields */
+	const uint64_t SERIES_ALIGNMENT = 64;
+
+	/** @brief Maximum number of fields */
+	const unsigned int SERIES_MAX_FIELDS = 8;
+
+	/** @brief Magic number of a time step block ("STEP") */
+	const uint32_t SERIES_STEP_MAGIC = 0x50455453;
+
+	/**
+	 * @brief Header at the start of the file
+	 */
+	struct SeriesHeader
+	{
+		/** @brief SERIES_MAGIC */
+		char magic[8];
+		/** @brief SERIES_VERSION */
+		uint32_t version;
+		/** @brief Size of a value in bytes (4 or 8) */
+		uint32_t scalarSize;
+		/** @brief Number of cells (without boundary values) */
+		uint32_t cells;
+		/** @brief Number of fields per time step */
+		uint32_t fields;
+		/** @brief Size of a cell */
+		double cellSize;
+		/** @brief Size of a time step block in bytes */
+		uint64_t blockSize;
+		/** @brief Offset of the first time step block */
+		uint64_t dataOffset;
+		/** @brief Offset of the index, 0 if the file was not closed properly */
+		uint64_t indexOffset;
+		/** @brief Number of time steps in the index */
+		uint64_t steps;
+		/** @brief Names of the fields */
+		char fieldNames[SERIES_MAX_FIELDS][16];
+	};
+
+	/**
+	 * @brief Header of a time step block
+	 */
+	struct SeriesStepHeader
+	{
+		/** @brief SERIES_STEP_MAGIC */
+		uint32_t magic;
+		/** @brief Reserved */
+		uint32_t reserved;
+		/** @brief Number of the time step in the file */
+		uint64_t step;
+		/** @brief Simulation time */
+		double time;
+		/** @brief Padding to SERIES_ALIGNMENT */
+		char padding[40];
+	};
+
+	/**
+	 * @brief Entry of the index
+	 */
+	struct SeriesIndexEntry
+	{
+		/** @brief Simulation time */
+		double time;
+		/** @brief Offset of the time step block */
+		uint64_t offset;
+	};
+
+	/**
+	 * @brief Computes the size of a padded field
+	 *
+	 * @param cells Number of cells
+	 * @param scalarSize Size of a value in bytes
+	 */
+	inline uint64_t seriesFieldSize(uint64_t cells, uint64_t scalarSize)
+	{
+		return (cells * scalarSize + SERIES_ALIGNMENT - 1) / SERIES_ALIGNMENT * SERIES_ALIGNMENT;
+	}
+
+}
+
+#endif /* SERIESFORMAT_H_ */
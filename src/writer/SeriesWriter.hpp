@@ -0,0 +1,222 @@
+/**
+ * @file SeriesWriter.hpp
+ * @brief Writes all time steps to a single binary file
+ */
+
+#ifndef SERIESWRITER_H_
+#define SERIESWRITER_H_
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "SeriesFormat.hpp"
+#include "DerivedFields.hpp"
+#include "../tools/logger.hpp"
+
+namespace writer
+{
+
+	/**
+	 * @brief A writer class that appends every time step to one file
+	 *
+	 * See SeriesFormat.hpp for the layout of the file. reader::SeriesReader
+	 * provides random access to the time steps. The froude numbers are computed
+	 * while the time step is written.
+	 *
+	 * After a restart, the writer keeps the time steps written before the checkpoint,
+	 * cuts the file after them and appends the following time steps.
+	 */
+	template<typename T> class SeriesWriter
+	{
+
+	private:
+
+		/** @brief The output file */
+		std::ofstream m_file;
+
+		/** @brief The header, written again when the file is closed */
+		SeriesHeader m_header;
+
+		/** @brief Index of all written time steps */
+		std::vector<SeriesIndexEntry> m_index;
+
+		/** @brief Zeros used for padding */
+		std::vector<char> m_padding;
+
+		/** @brief Computes the froude numbers */
+		DerivedFields<T> m_derived;
+
+		/** @brief Buffer for the froude numbers (with boundary values) */
+		std::vector<T> m_buffer;
+
+	public:
+
+		/**
+		 * @brief Constructor
+		 *
+		 * @param basename The filename of the output file without extension
+		 * @param cellSize The size of a cell
+		 * @param steps Number of time steps kept from an existing file (restart), a new file is started if 0
+		 */
+		SeriesWriter(const std::string& basename = "swe1d", const T cellSize = 1, unsigned long long steps = 0)
+			: m_padding(SERIES_ALIGNMENT, 0)
+		{
+			std::string fileName = basename + ".series";
+			if (steps > 0)
+			{
+				resume(fileName, steps);
+				return;
+			}
+
+			m_file.open(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+			assert(m_file.good());
+
+			std::memset(&m_header, 0, sizeof(m_header));
+			std::memcpy(m_header.magic, SERIES_MAGIC, sizeof(SERIES_MAGIC));
+			m_header.version = SERIES_VERSION;
+			m_header.scalarSize = sizeof(T);
+			m_header.fields = 4;
+			m_header.cellSize = cellSize;
+			m_header.dataOffset = sizeof(SeriesHeader);
+			std::strcpy(m_header.fieldNames[0], "h");
+			std::strcpy(m_header.fieldNames[1], "hu");
+			std::strcpy(m_header.fieldNames[2], "b");
+			std::strcpy(m_header.fieldNames[3], "f");
+
+			// The number of cells is known with the first time step
+			m_file.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+		}
+
+		/**
+		 * @brief Destructor, writes the index
+		 */
+		~SeriesWriter()
+		{
+			m_header.indexOffset = m_file.tellp();
+			m_header.steps = m_index.size();
+			if (!m_index.empty())
+				m_file.write(reinterpret_cast<const char*>(&m_index[0]),
+					m_index.size() * sizeof(SeriesIndexEntry));
+
+			m_file.seekp(0);
+			m_file.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+		}
+
+		/**
+		 * @brief Approximates the froude numbers with the reciprocal square root, see writer::DerivedFields
+		 *
+		 * @param fast Use the fast mode of kernels::CellBatch
+		 */
+		void setFastFroude(bool fast)
+		{
+			m_derived.setFast(fast);
+		}
+
+		/**
+		 * @brief Appends all values (without boundary values) to the file
+		 *
+		 * @param time Current time
+		 * @param h Current height
+		 * @param hu Current flux
+		 * @param b Current bathymetry
+		 * @param size Number of cells (without boundary values)
+		 * @param x Grid points, has to be null (only uniform grids are supported)
+		 */
+		void write(const T time, const T *h, const T *hu, const T *b, unsigned int size,
+			const T *x = 0L)
+		{
+			assert(!x);
+
+			if (m_index.empty())
+			{
+				// Header with the final block size, in case the file is not closed properly
+				m_header.cells = size;
+				m_header.blockSize = sizeof(SeriesStepHeader) + m_header.fields * seriesFieldSize(size, sizeof(T));
+				m_file.seekp(0);
+				m_file.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+				m_file.seekp(m_header.dataOffset);
+			}
+			assert(size == m_header.cells);
+
+			SeriesIndexEntry entry;
+			entry.time = time;
+			entry.offset = m_header.dataOffset + m_index.size() * m_header.blockSize;
+			m_index.push_back(entry);
+
+			SeriesStepHeader stepHeader;
+			std::memset(&stepHeader, 0, sizeof(stepHeader));
+			stepHeader.magic = SERIES_STEP_MAGIC;
+			stepHeader.step = m_index.size()-1;
+			stepHeader.time = time;
+			m_file.write(reinterpret_cast<const char*>(&stepHeader), sizeof(stepHeader));
+
+			writeField(h, size);
+			writeField(hu, size);
+			writeField(b, size);
+
+			m_buffer.resize(size+1);
+			m_derived.compute(DerivedFields<T>::FROUDE, h, hu, b, 1, size+1, &m_buffer[1]);
+			writeField(&m_buffer[0], size);
+		}
+
+	private:
+
+		/**
+		 * @brief Continues an existing file after its first steps time steps
+		 *
+		 * The index of the kept time steps is rebuilt from their step headers, so files
+		 * that were not closed properly can be continued as well.
+		 */
+		void resume(const std::string &fileName, unsigned long long steps)
+		{
+			std::ifstream previous(fileName.c_str(), std::ios::in | std::ios::binary);
+			if (!previous.read(reinterpret_cast<char*>(&m_header), sizeof(m_header))
+					|| std::memcmp(m_header.magic, SERIES_MAGIC, sizeof(SERIES_MAGIC)) != 0
+					|| m_header.scalarSize != sizeof(T) || m_header.blockSize == 0)
+				tools::Logger::logger.error(("Can not continue the series file " + fileName).c_str());
+
+			m_index.resize(steps);
+			for (unsigned long long step = 0; step < steps; step++)
+			{
+				SeriesStepHeader stepHeader;
+				m_index[step].offset = m_header.dataOffset + step * m_header.blockSize;
+				previous.seekg(m_index[step].offset);
+				if (!previous.read(reinterpret_cast<char*>(&stepHeader), sizeof(stepHeader))
+						|| stepHeader.magic != SERIES_STEP_MAGIC)
+					tools::Logger::logger.error(("The series file " + fileName
+						+ " has fewer time steps than the checkpoint").c_str());
+				m_index[step].time = stepHeader.time;
+			}
+			previous.close();
+
+			// Drop the later time steps and the index, they are written again
+			const unsigned long long end = m_header.dataOffset + steps * m_header.blockSize;
+			if (truncate(fileName.c_str(), end) != 0)
+				tools::Logger::logger.error(("Can not continue the series file " + fileName).c_str());
+
+			m_header.indexOffset = 0;
+			m_header.steps = 0;
+			m_file.open(fileName.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+			assert(m_file.good());
+			m_file.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+			m_file.seekp(end);
+		}
+
+		/**
+		 * @brief Writes a field without boundary values and pads it
+		 */
+		void writeField(const T *values, unsigned int size)
+		{
+			unsigned long long bytes = size * sizeof(T);
+			m_file.write(reinterpret_cast<const char*>(values+1), bytes);
+			m_file.write(&m_padding[0], seriesFieldSize(size, sizeof(T)) - bytes);
+		}
+
+	};
+
+}
+
+#endif /* SERIESWRITER_H_ */
@@ -6,21 +6,43 @@
 #ifndef VTKWRITER_H_
 #define VTKWRITER_H_
 
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
 #include <fstream>
 #include <sstream>
 #include <string>
-#include "../types.hpp"
+#include <vector>
+#include "DerivedFields.hpp"
+#include "../tools/compression.hpp"
+#include "../tools/logger.hpp"
 
 namespace writer
 {
 
 	/**
 	 * @brief A writer class that generates vtk files
+	 *
+	 * The data arrays are either written as ASCII text or as raw binary data
+	 * in the appended data section of the file. Binary arrays can be compressed
+	 * in independent blocks (VTK's zlib or LZ4 compressors), see setCompression.
+	 *
+	 * Optionally, only some regions of the domain are written. Each region
+	 * is written to its own file and becomes a separate part in the collection.
+	 *
+	 * The derived fields (see DerivedFields) are computed while the file is written.
 	 */
-	class VtkWriter
+	template<typename T> class VtkWriter
 	{
 
+	public:
+
+		/** @brief The possible encodings of the data arrays */
+		enum Format { ASCII, BINARY };
+
+		/** @brief A region of cells [first, last) (without boundary values) */
+		typedef std::pair<unsigned int, unsigned int> Region;
+
 	private:
 
 		/** @brief Base name of the vtp collectiond and vtk files */
@@ -32,9 +54,47 @@ namespace writer
 		/** @brief Current time step */
 		unsigned int m_timeStep;
 
-		/** @brief VTP stream */
+		/** @brief VTP stream, null if no collection is written */
 		std::ofstream *m_vtpFile;
 
+		/** @brief Encoding of the data arrays */
+		Format m_format;
+
+		/** @brief Grid point coordinates, computed once for binary files */
+		std::vector<T> m_coordinates;
+
+		/** @brief Buffer for derived arrays in binary files */
+		std::vector<T> m_buffer;
+
+		/** @brief Computes the derived arrays */
+		DerivedFields<T> m_derived;
+
+		/** @brief The regions that are written, the whole domain if empty */
+		std::vector<Region> m_regions;
+
+		/** @brief Index of the first written cell in the whole domain (pieces of a distributed domain) */
+		unsigned int m_offset;
+
+		/** @brief Number of cells of the whole domain, 0 if the domain is not distributed */
+		unsigned int m_wholeSize;
+
+		/** @brief Compression of the binary arrays */
+		tools::Compression::Method m_compression;
+
+		/** @brief Uncompressed size of a block in bytes */
+		unsigned int m_blockSize;
+
+		/** @brief Compression level, the default of the library if negative */
+		int m_level;
+
+		/** @brief Number of threads that compress the blocks */
+		unsigned int m_threads;
+
+		/** @brief The compressed blocks of all arrays */
+		std::vector<std::vector<char> > m_blocks;
+
+		/** @brief The compressed sizes of the blocks */
+		std::vector<unsigned long long> m_blockBytes;
 
 	public:
 
@@ -43,12 +103,30 @@ namespace writer
 		 * 
 		 * @param basename The filename of the output file without extension
 		 * @param cellSize The size of a cell
+		 * @param format The encoding of the data arrays
+		 * @param timeStep The number of the first file. After a restart, the collection keeps
+		 *  the files of the earlier run before it and continues with this one.
+		 * @param collection Write the collection basename.vtp, disabled for the pieces of
+		 *  writer::ParallelVtkWriter, which lists the parallel files instead
 		 */
-		VtkWriter( const std::string& basename = "swe1d", const T cellSize = 1) : m_basename(basename), m_cellSize(cellSize), m_timeStep(0)
+		VtkWriter( const std::string& basename = "swe1d", const T cellSize = 1, Format format = ASCII,
+			unsigned int timeStep = 0, bool collection = true)
+			: m_basename(basename), m_cellSize(cellSize), m_timeStep(timeStep), m_vtpFile(0L), m_format(format),
+			  m_offset(0), m_wholeSize(0), m_compression(tools::Compression::NONE), m_blockSize(32768),
+			  m_level(-1), m_threads(1)
 		{
+			if (!collection)
+				return;
+
 			// initialize vtp stream
 			std::ostringstream l_vtpFileName;
 			l_vtpFileName << m_basename << ".vtp";
+
+			// The entries of the files written before a restart
+			std::vector<std::string> previous;
+			if (timeStep > 0)
+				readCollection(l_vtpFileName.str(), previous);
+
 			m_vtpFile = new std::ofstream( l_vtpFileName.str().c_str() );
 
 			// write vtp header
@@ -56,12 +134,17 @@ namespace writer
 				<< "<?xml version=\"1.0\"?>" << std::endl
 				<< "<VTKFile type=\"Collection\" version=\"0.1\">" << std::endl
 				<< "<Collection>" << std::endl;
+			for (unsigned int i = 0; i < previous.size(); i++)
+				*m_vtpFile << previous[i] << std::endl;
 		}
 
 		/**
 		 * @brief Destructor
 		 */
 		~VtkWriter() {
+			if (!m_vtpFile)
+				return;
+
 			// close vtp file
 			*m_vtpFile
 				<< "</Collection>" << std::endl
@@ -69,6 +152,62 @@ namespace writer
 			delete m_vtpFile;	
 		}
 
+		/**
+		 * @brief Restricts the output to some regions of the domain
+		 *
+		 * @param regions The regions that should be written, the whole domain if empty
+		 */
+		void setRegions(const std::vector<Region> &regions)
+		{
+			m_regions = regions;
+		}
+
+		/**
+		 * @brief Approximates the froude numbers with the reciprocal square root, see writer::DerivedFields
+		 *
+		 * @param fast Use the fast mode of kernels::CellBatch
+		 */
+		void setFastFroude(bool fast)
+		{
+			m_derived.setFast(fast);
+		}
+
+		/**
+		 * @brief Writes the domain as a piece of a larger domain
+		 *
+		 * The extent and the coordinates refer to the whole domain, see writer::ParallelVtkWriter.
+		 *
+		 * @param offset Index of the first cell in the whole domain
+		 * @param wholeSize Number of cells of the whole domain
+		 */
+		void setPiece(unsigned int offset, unsigned int wholeSize)
+		{
+			m_offset = offset;
+			m_wholeSize = wholeSize;
+			m_coordinates.clear();
+		}
+
+		/**
+		 * @brief Compresses the binary arrays in independent blocks
+		 *
+		 * Only used with the binary format. ParaView decompresses the arrays when it
+		 * opens the files.
+		 *
+		 * @param compression The compression method
+		 * @param blockSize Uncompressed size of a block in bytes (rounded down to whole values)
+		 * @param level The compression level (1-9), the default of the library if negative
+		 * @param threads Number of threads that compress the blocks
+		 */
+		void setCompression(tools::Compression::Method compression, unsigned int blockSize = 32768,
+			int level = -1, unsigned int threads = 1)
+		{
+			m_compression = compression;
+			// Blocks hold whole values
+			m_blockSize = std::max(blockSize / (unsigned int) sizeof(T), 1u) * sizeof(T);
+			m_level = level;
+			m_threads = std::max(threads, 1u);
+		}
+
 		/**
 		 * @brief Writes all values to vtk file
 		 *
@@ -76,39 +215,90 @@ namespace writer
 		 * @param h Current height
 		 * @param hu Current flux
 		 * @param b Current bathymetry
-		 * @param f Current frode number
 		 * @param size Number of cells (without boundary values)
+		 * @param x The size+1 grid points of a non-uniform grid, null for a uniform grid
 		 */
-		void write(const T time, const T *h, const T *hu, const T *b, const T *f, unsigned int size)
+		void write(const T time, const T *h, const T *hu, const T *b, unsigned int size,
+			const T *x = 0L)
+		{
+			if (m_regions.empty())
+				writeRegion(time, 0, h, hu, b, x, 0, size);
+
+			for (unsigned int part = 0; part < m_regions.size(); part++)
+			{
+				unsigned int first = std::min(m_regions[part].first, size);
+				unsigned int last = std::min(m_regions[part].second, size);
+				if (first < last)
+					writeRegion(time, part, h, hu, b, x, first, last);
+			}
+
+			// increment time step
+			m_timeStep++;
+		}
+
+	private:
+
+		/**
+		 * @brief Writes the values of a region to a vtk file
+		 *
+		 * @param time Current time
+		 * @param part The number of the region
+		 * @param h Current height
+		 * @param hu Current flux
+		 * @param b Current bathymetry
+		 * @param x The grid points, null for a uniform grid
+		 * @param first The first cell of the region
+		 * @param last One past the last cell of the region
+		 */
+		void writeRegion(const T time, unsigned int part, const T *h, const T *hu, const T *b,
+			const T *x, unsigned int first, unsigned int last)
 		{
 			// generate vtk file name
-			std::string l_fileName = generateFileName();
+			std::string l_fileName = generateFileName(part);
 
 			// add current time to vtp collection
-			*m_vtpFile << "<DataSet timestep=\""
+			if (m_vtpFile)
+				*m_vtpFile << "<DataSet timestep=\""
 						<< time
-						<< "0\" group=\"\" part=\"0\" file=\""
+						<< "0\" group=\"\" part=\"" << part << "\" file=\""
 						<< l_fileName
 						<< "\"/> " << std::endl;
 
 			// write vtk file
-			std::ofstream vtkFile(l_fileName.c_str());
+			std::ofstream vtkFile(l_fileName.c_str(), std::ios::out | std::ios::binary);
 			assert(vtkFile.good());
 
 			// vtk xml header
 			vtkFile << "<?xml version=\"1.0\"?>" << std::endl
-					<< "<VTKFile type=\"RectilinearGrid\">" << std::endl
-					<< "<RectilinearGrid WholeExtent=\"0 " << size
-						<< " 0 0 0 0\">" << std::endl
-					<< "<Piece Extent=\"0 " << size
+					<< "<VTKFile type=\"RectilinearGrid\"";
+			if (m_format == BINARY)
+				vtkFile << " version=\"0.1\" byte_order=\"" << byteOrder() << "\" header_type=\"UInt64\"";
+			if (m_format == BINARY && m_compression != tools::Compression::NONE)
+				vtkFile << " compressor=\"" << tools::Compression::vtkCompressor(m_compression) << "\"";
+			vtkFile << ">" << std::endl
+					<< "<RectilinearGrid WholeExtent=\"" << (m_wholeSize ? 0 : first) << " "
+						<< (m_wholeSize ? m_wholeSize : last) << " 0 0 0 0\">" << std::endl
+					<< "<Piece Extent=\"" << m_offset + first << " " << m_offset + last
 						<< " 0 0 0 0\">" << std::endl;
 
+			if (m_format == BINARY)
+				writeBinary(vtkFile, h, hu, b, x, first, last);
+			else
+				writeAscii(vtkFile, h, hu, b, x, first, last);
+		}
+
+		/**
+		 * @brief Writes the coordinates and cell data as ASCII text
+		 */
+		void writeAscii(std::ofstream &vtkFile, const T *h, const T *hu, const T *b,
+			const T *x, unsigned int first, unsigned int last)
+		{
 			vtkFile << "<Coordinates>" << std::endl
 				<< "<DataArray type=\"Float32\" format=\"ascii\">" << std::endl;
 
 			// grid points
-			for (int i=0; i < size+1; i++)
-				vtkFile << m_cellSize * i << "" << std::endl;
+			for (unsigned int i=first; i < last+1; i++)
+				vtkFile << (x ? x[i] : m_cellSize * (m_offset + i)) << '\n';
 
 			vtkFile << "</DataArray>" << std::endl;
 
@@ -126,50 +316,288 @@ namespace writer
 
 			// water surface height
 			vtkFile << "<DataArray Name=\"h\" type=\"Float32\" format=\"ascii\">" << std::endl;
-			for (int i=1; i < size+1; i++) vtkFile << h[i] << std::endl;
+			for (unsigned int i=first+1; i < last+1; i++) vtkFile << h[i] << '\n';
 			vtkFile << "</DataArray>" << std::endl;
 
 			// momentum
 			vtkFile << "<DataArray Name=\"hu\" type=\"Float32\" format=\"ascii\">" << std::endl;
-			for (int i=1; i < size+1; i++) vtkFile << hu[i] << std::endl;
+			for (unsigned int i=first+1; i < last+1; i++) vtkFile << hu[i] << '\n';
 			vtkFile << "</DataArray>" << std::endl;
 
 			// bathymetry
 			vtkFile << "<DataArray Name=\"b\" type=\"Float32\" format=\"ascii\">" << std::endl;
-			for (int i=1; i<size+1; i++) vtkFile << b[i] << std::endl;
+			for (unsigned int i=first+1; i < last+1; i++) vtkFile << b[i] << '\n';
 			vtkFile << "</DataArray>" << std::endl;
 
-			// bathymetry + water height
-			vtkFile << "<DataArray Name=\"b+h\" type=\"Float32\" format=\"ascii\">" << std::endl;
-			for (int i=1; i<size+1; i++) vtkFile << b[i] + h[i] << std::endl;
-			vtkFile << "</DataArray>" << std::endl;
-
-			// frode number
-			vtkFile << "<DataArray Name=\"f\" type=\"Float32\" format=\"ascii\">" << std::endl;
-			for (int i=1; i<size+1; i++) vtkFile << f[i] << std::endl;
-			vtkFile << "</DataArray>" << std::endl;
+			// bathymetry + water height and frode number
+			for (unsigned int j=0; j < DerivedFields<T>::FIELDS; j++)
+			{
+				typename DerivedFields<T>::Field field = static_cast<typename DerivedFields<T>::Field>(j);
+				vtkFile << "<DataArray Name=\"" << DerivedFields<T>::name(field) << "\" type=\"Float32\" format=\"ascii\">" << std::endl;
+				for (unsigned int i=first+1; i < last+1; i++) vtkFile << m_derived.value(field, h[i], hu[i], b[i]) << '\n';
+				vtkFile << "</DataArray>" << std::endl;
+			}
 
 			vtkFile << "</CellData>" << std::endl
 					<< "</Piece>" << std::endl;
 
 			vtkFile << "</RectilinearGrid>" << std::endl
 					<< "</VTKFile>" << std::endl;
+		}
 
-			// increment time step
-			m_timeStep++;
+		/**
+		 * @brief A binary data array
+		 */
+		struct Array
+		{
+			/** @brief The name of the array */
+			const char *name;
+			/** @brief The values */
+			const T *data;
+			/** @brief Number of values */
+			unsigned int count;
+		};
+
+		/**
+		 * @brief Writes the coordinates and cell data in the appended data section
+		 *
+		 * Each array is stored as a 64 bit byte count followed by the raw values,
+		 * or as the header of the blocks followed by the compressed blocks.
+		 */
+		void writeBinary(std::ofstream &vtkFile, const T *h, const T *hu, const T *b,
+			const T *x, unsigned int first, unsigned int last)
+		{
+			unsigned int size = last - first;
+
+			// grid points of a uniform grid, only computed once
+			if (!x && m_coordinates.size() < last+1)
+			{
+				m_coordinates.resize(last+1);
+				for (unsigned int i=0; i < last+1; i++)
+					m_coordinates[i] = m_cellSize * (m_offset + i);
+			}
+
+			m_buffer.resize(DerivedFields<T>::FIELDS * size);
+			for (unsigned int j=0; j < DerivedFields<T>::FIELDS; j++)
+				m_derived.compute(static_cast<typename DerivedFields<T>::Field>(j), h, hu, b,
+					first+1, last+1, &m_buffer[j*size]);
+
+			// three coordinates, h, hu, b and the derived fields
+			const unsigned int count = 6 + DerivedFields<T>::FIELDS;
+			const T zero = 0;
+			Array arrays[count] = {
+				{"x", x ? x+first : &m_coordinates[first], size+1},
+				{"y", &zero, 1},
+				{"z", &zero, 1},
+				{"h", h+first+1, size},
+				{"hu", hu+first+1, size},
+				{"b", b+first+1, size}};
+			for (unsigned int j=0; j < DerivedFields<T>::FIELDS; j++)
+			{
+				Array derived = {DerivedFields<T>::name(static_cast<typename DerivedFields<T>::Field>(j)),
+					&m_buffer[j*size], size};
+				arrays[6+j] = derived;
+			}
+
+			const bool compressed = m_compression != tools::Compression::NONE;
+			if (compressed)
+				compress(arrays, count);
+
+			const char* type = sizeof(T) == 8 ? "Float64" : "Float32";
+			unsigned long long offset = 0;
+			unsigned int block = 0;
+
+			vtkFile << "<Coordinates>" << std::endl;
+			for (unsigned int i=0; i < count; i++)
+			{
+				if (i == 3)
+					vtkFile << "</Coordinates>" << std::endl
+							<< "<CellData>" << std::endl;
+				writeAppendedHeader(vtkFile, type, arrays[i].name, offset);
+				offset += compressed ? compressedBytes(arrays[i], block) : rawBytes(arrays[i]);
+			}
+			vtkFile << "</CellData>" << std::endl
+					<< "</Piece>" << std::endl
+					<< "</RectilinearGrid>" << std::endl;
+
+			// raw data, starts after the underscore
+			vtkFile << "<AppendedData encoding=\"raw\">" << std::endl << '_';
+
+			block = 0;
+			for (unsigned int i=0; i < count; i++)
+			{
+				if (compressed)
+					writeCompressedData(vtkFile, arrays[i], block);
+				else
+					writeAppendedData(vtkFile, arrays[i].data, arrays[i].count);
+			}
+
+			vtkFile << std::endl << "</AppendedData>" << std::endl
+					<< "</VTKFile>" << std::endl;
 		}
 
-	private:
+		/**
+		 * @brief Compresses the blocks of all arrays in parallel
+		 */
+		void compress(const Array *arrays, unsigned int count)
+		{
+			// The blocks of all arrays, numbered consecutively
+			std::vector<std::pair<unsigned int, unsigned int> > tasks;
+			for (unsigned int i=0; i < count; i++)
+				for (unsigned int j=0; j < blocks(arrays[i]); j++)
+					tasks.push_back(std::make_pair(i, j));
+
+			m_blocks.resize(tasks.size());
+			m_blockBytes.resize(tasks.size());
+
+			#pragma omp parallel for num_threads(m_threads) schedule(dynamic)
+			for (unsigned int t=0; t < tasks.size(); t++)
+			{
+				const Array &array = arrays[tasks[t].first];
+				const unsigned long long begin = (unsigned long long) tasks[t].second * m_blockSize;
+				const unsigned long long bytes = std::min(rawBytes(array) - sizeof(unsigned long long) - begin,
+					(unsigned long long) m_blockSize);
+
+				m_blocks[t].resize(tools::Compression::bound(m_compression, bytes));
+				m_blockBytes[t] = tools::Compression::compress(m_compression, m_level,
+					reinterpret_cast<const char*>(array.data) + begin, bytes, &m_blocks[t][0]);
+			}
+		}
+
+		/**
+		 * @brief Number of blocks of an array
+		 */
+		unsigned int blocks(const Array &array) const
+		{
+			return ((unsigned long long) array.count * sizeof(T) + m_blockSize-1) / m_blockSize;
+		}
+
+		/**
+		 * @brief The size of an uncompressed array in the appended data section
+		 */
+		static unsigned long long rawBytes(const Array &array)
+		{
+			return sizeof(unsigned long long) + (unsigned long long) array.count * sizeof(T);
+		}
+
+		/**
+		 * @brief The size of a compressed array in the appended data section
+		 *
+		 * @param array The array
+		 * @param[in,out] block The first block of the array, incremented by the number of blocks
+		 */
+		unsigned long long compressedBytes(const Array &array, unsigned int &block) const
+		{
+			const unsigned int n = blocks(array);
+			unsigned long long bytes = (3 + n) * sizeof(unsigned long long);
+			for (unsigned int j=0; j < n; j++)
+				bytes += m_blockBytes[block++];
+			return bytes;
+		}
+
+		/**
+		 * @brief Writes the xml tag of an appended data array
+		 *
+		 * @param vtkFile The vtk file
+		 * @param type The vtk data type
+		 * @param name The name of the array
+		 * @param offset The offset of the array
+		 */
+		static void writeAppendedHeader(std::ofstream &vtkFile, const char* type, const char* name,
+			unsigned long long offset)
+		{
+			vtkFile << "<DataArray Name=\"" << name << "\" type=\"" << type
+				<< "\" format=\"appended\" offset=\"" << offset << "\"/>" << std::endl;
+		}
+
+		/**
+		 * @brief Writes the byte count and the values of an appended data array
+		 */
+		static void writeAppendedData(std::ofstream &vtkFile, const T *data, unsigned int count)
+		{
+			unsigned long long bytes = count * sizeof(T);
+			vtkFile.write(reinterpret_cast<const char*>(&bytes), sizeof(bytes));
+			vtkFile.write(reinterpret_cast<const char*>(data), bytes);
+		}
+
+		/**
+		 * @brief Writes the header of the blocks and the compressed blocks of an array
+		 *
+		 * The header holds the number of blocks, the uncompressed size of a block,
+		 * the uncompressed size of the last block if it is partial (0 otherwise)
+		 * and the compressed size of every block.
+		 *
+		 * @param vtkFile The vtk file
+		 * @param array The array
+		 * @param[in,out] block The first block of the array, incremented by the number of blocks
+		 */
+		void writeCompressedData(std::ofstream &vtkFile, const Array &array, unsigned int &block)
+		{
+			const unsigned int n = blocks(array);
+			std::vector<unsigned long long> header(3 + n);
+			header[0] = n;
+			header[1] = m_blockSize;
+			header[2] = ((unsigned long long) array.count * sizeof(T)) % m_blockSize;
+			for (unsigned int j=0; j < n; j++)
+				header[3+j] = m_blockBytes[block+j];
+			vtkFile.write(reinterpret_cast<const char*>(&header[0]), header.size() * sizeof(unsigned long long));
+
+			for (unsigned int j=0; j < n; j++, block++)
+				vtkFile.write(&m_blocks[block][0], m_blockBytes[block]);
+		}
+
+		/**
+		 * @brief The byte order of this machine in vtk notation
+		 */
+		static const char* byteOrder()
+		{
+			const unsigned int one = 1;
+			if (*reinterpret_cast<const char*>(&one) == 1)
+				return "LittleEndian";
+			return "BigEndian";
+		}
+
+		/**
+		 * @brief Reads the entries of the files before the first time step from an existing collection
+		 *
+		 * @param fileName The vtp file
+		 * @param[out] entries The DataSet lines of the files
+		 */
+		void readCollection(const std::string &fileName, std::vector<std::string> &entries) const
+		{
+			std::ifstream vtp(fileName.c_str());
+			if (!vtp)
+			{
+				tools::Logger::logger.warning(("The collection " + fileName
+					+ " does not exist, it only lists the files after the restart").c_str());
+				return;
+			}
+
+			const std::string file = "file=\"" + m_basename + '_';
+			std::string line;
+			while (std::getline(vtp, line))
+			{
+				const size_t pos = line.find(file);
+				if (line.compare(0, 8, "<DataSet") == 0 && pos != std::string::npos
+						&& std::strtoul(line.c_str() + pos + file.size(), 0L, 10) < m_timeStep)
+					entries.push_back(line);
+			}
+		}
 
 		/**
 		 * @brief Generates a vtr file name
 		 * 
-		 * @return The generated filename containing the time step and the real name
+		 * @param part The number of the region
+		 *
+		 * @return The generated filename containing the time step (and the region) and the real name
 		 */
-		std::string generateFileName()
+		std::string generateFileName(unsigned int part = 0)
 		{
 			std::ostringstream name;
-			name << m_basename << '_' << m_timeStep << ".vtr";
+			name << m_basename << '_' << m_timeStep;
+			if (m_regions.size() > 1)
+				name << '_' << part;
+			name << ".vtr";
 			return name.str();
 		}
 		